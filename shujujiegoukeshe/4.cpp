@@ -2,221 +2,358 @@
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include "avl_tree.h"
+#include "prime_sieve.h"
 using namespace std;
 
-// 定义AVL树的节点结构
-struct Node {
-    int data;
-    int height;  // 节点的高度
-    Node* left;
-    Node* right;
-    Node(int val) : data(val), height(0), left(nullptr), right(nullptr) {}
-};
-
-// 获取节点高度
-int height(Node* node) {
-    return node == nullptr ? -1 : node->height;
-}
-
-// 更新节点的高度
-void updateHeight(Node* &node) {
-    if (node == nullptr) return;
-    int leftHeight = (node->left != nullptr) ? node->left->height : -1;
-    int rightHeight = (node->right != nullptr) ? node->right->height : -1;
-    node->height = max(leftHeight, rightHeight) + 1;
-}
-
-// 获取平衡因子
-int balanceFactor(Node* node) {
-    return height(node->left) - height(node->right);
-}
-
-// 左旋操作
-void leftRotate(Node*& root) {
-    Node* child = root->right;
-    if (child == nullptr) return;
-    Node* grandchild = child->left;
-    child->left = root;
-    root->right = grandchild;
-    updateHeight(root);
-    updateHeight(child);
-    root = child;  
+// 从 n 到 m 生成质数并返回(分段筛只处理[n, m]所在的段)
+vector<int> generatePrimes(int n, int m) 
+{
+    vector<int> result;
+    forEachPrime(max(n, 0), max(m, 0), [&](uint64_t prime) 
+    {
+        result.push_back((int)prime);
+    });
+    return result;
 }
 
-// 右旋操作
-void rightRotate(Node*& root) {
-    Node* child = root->left;
-    Node* grandchild = child->right;
-    child->right = root;
-    root->left = grandchild;
-    updateHeight(root);
-    updateHeight(child);
-    root = child;  
+// 写入查询结果到文件
+void writeQueryResults(const vector<int>& queries, const AVLTree& tree, const string& filename) 
+{
+    ofstream outfile(filename);
+    vector<bool> found = tree.searchSorted(queries);
+    for (size_t i = 0; i < queries.size(); ++i) 
+    {
+        outfile << queries[i] << " " << (found[i] ? "yes" : "no") << endl;
+    }
+    outfile.close();
 }
 
-// 插入操作
-void insert(Node*& root, int value) {
-    if (root == nullptr) {
-        root = new Node(value);
-        return;
-    }
-    if (value < root->data) {
-        insert(root->left, value);
-    } else if (value > root->data) {
-        insert(root->right, value);
+// 写入某个历史版本的查询结果
+void writeSnapshotResults(const vector<int>& queries, const PersistentAVL& history,
+                          const PersistentAVL::Version& version, const string& filename) 
+{
+    ofstream outfile(filename);
+    for (int query : queries) 
+    {
+        outfile << query << " " << (history.search(version, query) ? "yes" : "no") << endl;
     }
+    outfile.close();
+}
 
-    updateHeight(root);
-
-    int balance = balanceFactor(root);
-
-    // 左左情况
-    if (balance > 1 && value < root->left->data) {
-        rightRotate(root);
-    }
-    // 右右情况
-    if (balance < -1 && value > root->right->data) {
-        leftRotate(root);
-    }
-    // 左右情况
-    if (balance > 1 && value > root->left->data) {
-        leftRotate(root->left);
-        rightRotate(root);
+// 检查以node为根的子树:关键字在(lo, hi)内且递增,高度和子树大小字段与孩子一致,平衡因子不超过1
+bool checkSubtree(const AVLTree& tree, int32_t node, long long lo, long long hi, int& height, int32_t& size) 
+{
+    if (node == NIL) 
+    {
+        height = -1;
+        size = 0;
+        return true;
     }
-    // 右左情况
-    if (balance < -1 && value < root->right->data) {
-        rightRotate(root->right);
-        leftRotate(root);
+    const AVLNode& n = tree.pool[node];
+    int leftHeight, rightHeight;
+    int32_t leftSize, rightSize;
+    if (n.data <= lo || n.data >= hi ||
+        !checkSubtree(tree, n.left, lo, n.data, leftHeight, leftSize) ||
+        !checkSubtree(tree, n.right, n.data, hi, rightHeight, rightSize)) 
+    {
+        return false;
     }
+    height = max(leftHeight, rightHeight) + 1;
+    size = leftSize + rightSize + 1;
+    return n.height == height && n.size == size && abs(leftHeight - rightHeight) <= 1;
 }
 
-// 删除节点
-Node* deleteNode(Node* root, int value) {
-    if (root == nullptr) return root;
-
-    if (value < root->data) {
-        root->left = deleteNode(root->left, value);
-    } else if (value > root->data) {
-        root->right = deleteNode(root->right, value);
-    } else {
-        if (root->left == nullptr) {
-            Node* temp = root->right;
-            delete root;
-            return temp;
-        } else if (root->right == nullptr) {
-            Node* temp = root->left;
-            delete root;
-            return temp;
-        } else {
-            Node* temp = root->right;
-            while (temp && temp->left != nullptr) {
-                temp = temp->left;
-            }
-            root->data = temp->data;
-            root->right = deleteNode(root->right, temp->data);
-        }
+// 把树的全部查询与递增数组reference逐一核对
+bool sameAsReference(const AVLTree& tree, const vector<int>& reference, mt19937& rng, int range) 
+{
+    int height;
+    int32_t size;
+    if (!checkSubtree(tree, tree.root, (long long)INT_MIN - 1, (long long)INT_MAX + 1, height, size) ||
+        (size_t)size != reference.size() || tree.size() != reference.size() || tree.inOrder() != reference) 
+    {
+        return false;
     }
+    for (int q = 0; q < 50; ++q) 
+    {
+        int x = (int)(rng() % (range + 2)) - 1, y = (int)(rng() % (range + 2)) - 1;
+        size_t less = lower_bound(reference.begin(), reference.end(), x) - reference.begin();
+        size_t notGreater = upper_bound(reference.begin(), reference.end(), x) - reference.begin();
+        size_t between = x > y ? 0 : upper_bound(reference.begin(), reference.end(), y) - reference.begin() - less;
+        if (tree.search(x) != (less < notGreater) || tree.countLess(x) != less || tree.rank(x) != notGreater ||
+            tree.countRange(x, y) != between) 
+        {
+            return false;
+        }
+        AVLTree::Iterator it = tree.lower_bound(x);
+        if (it.valid() != (less < reference.size()) || (it.valid() && *it != reference[less])) return false;
+        it = tree.upper_bound(x);
+        if (it.valid() != (notGreater < reference.size()) || (it.valid() && *it != reference[notGreater])) return false;
+        vector<int> expected(reference.begin() + less, reference.begin() + less + between);
+        if (tree.rangeQuery(x, y) != expected) return false;
 
-    updateHeight(root);
-
-    int balance = balanceFactor(root);
-
-    // 左左情况
-    if (balance > 1 && balanceFactor(root->left) >= 0) {
-        rightRotate(root);
-    }
-    // 右右情况
-    if (balance < -1 && balanceFactor(root->right) <= 0) {
-        leftRotate(root);
-    }
-    // 左右情况
-    if (balance > 1 && balanceFactor(root->left) < 0) {
-        leftRotate(root->left);
-        rightRotate(root);
+        int value = 0;
+        size_t k = rng() % (reference.size() + 2);
+        bool ok = tree.select(k, value);
+        if (ok != (k >= 1 && k <= reference.size()) || (ok && value != reference[k - 1])) return false;
+        double p = (rng() % 1001) / 10.0;
+        ok = tree.percentile(p, value);
+        if (ok != (p > 0 && !reference.empty())) return false;
+        if (ok) 
+        {
+            size_t nearest = min(max((size_t)ceil(p / 100.0 * reference.size()), size_t(1)), reference.size());
+            if (value != reference[nearest - 1]) return false;
+        }
     }
-    // 右左情况
-    if (balance < -1 && balanceFactor(root->right) > 0) {
-        rightRotate(root->right);
-        leftRotate(root);
+    vector<int> queries(20);
+    for (int& q : queries) q = (int)(rng() % (range + 1));
+    sort(queries.begin(), queries.end());
+    vector<bool> found = tree.searchSorted(queries);
+    for (size_t i = 0; i < queries.size(); ++i) 
+    {
+        if (found[i] != binary_search(reference.begin(), reference.end(), queries[i])) return false;
     }
-
-    return root;
+    return true;
 }
 
-// 查询节点
-bool search(Node* root, int value) 
+// PersistentAVL:同时保留至多50个版本,每次从随机一个旧版本派生新版本,或随机丢弃一个版本;
+// 每个版本与自己的有序数组核对,全部句柄释放后节点必须全部回收
+bool verifyPersistent(int rounds) 
 {
-    if (root == nullptr) return false;
-    if (value == root->data) return true;
-    if (value < root->data) return search(root->left, value);
-    return search(root->right, value);
-}
-
-// 生成质数
+    mt19937 rng(4096);
+    for (int round = 0; round < rounds; ++round) 
+    {
+        int range = 1 + (int)(rng() % 300);
+        PersistentAVL history;
+        vector<PersistentAVL::Version> versions;
+        vector<vector<int>> references;
+        versions.push_back(history.empty());
+        references.push_back({});
+        int steps = 1 + (int)(rng() % 200);
+        for (int step = 0; step < steps; ++step) 
+        {
+            if (versions.size() > 1 && (versions.size() >= 50 || rng() % 8 == 0)) 
+            {
+                size_t drop = rng() % versions.size();
+                swap(versions[drop], versions.back());
+                swap(references[drop], references.back());
+                versions.pop_back();
+                references.pop_back();
+            }
+            size_t from = rng() % versions.size();
+            int x = (int)(rng() % (range + 1));
+            vector<int> reference = references[from];
+            auto pos = lower_bound(reference.begin(), reference.end(), x);
+            if (rng() % 3) 
+            {
+                versions.push_back(history.insert(versions[from], x));
+                if (pos == reference.end() || *pos != x) reference.insert(pos, x);
+            } 
+            else 
+            {
+                versions.push_back(history.deleteNode(versions[from], x));
+                if (pos != reference.end() && *pos == x) reference.erase(pos);
+            }
+            references.push_back(reference);
 
-// 写入查询结果到文件
-vector<int> Eratosthenes(int m) {
-    vector<bool> isPrime(m + 1, true);
-    isPrime[0] = isPrime[1] = false; 
-    for (int i = 2; i * i <= m; ++i) 
-    {
-        if (isPrime[i]) {
-            for (int j = i * i; j <= m; j += i) {
-                isPrime[j] = false;
+            // 新版本以及所有旧版本都不能受影响
+            for (size_t v = 0; v < versions.size(); ++v) 
+            {
+                if (history.inOrder(versions[v]) != references[v] || !history.balanced(versions[v]) ||
+                    history.search(versions[v], x) != binary_search(references[v].begin(), references[v].end(), x)) 
+                {
+                    cerr << "第" << round << "轮第" << step << "步PersistentAVL的版本" << v << "与参考结果不一致" << endl;
+                    return false;
+                }
             }
         }
-    }
-
-    vector<int> primes;
-    for (int i = 2; i <= m; ++i) 
-    {
-        if (isPrime[i]) {
-            primes.push_back(i);
+        versions.clear();
+        if (history.liveNodes() != 0) 
+        {
+            cerr << "第" << round << "轮释放全部版本后仍有" << history.liveNodes() << "个节点未回收" << endl;
+            return false;
         }
     }
-
-    return primes;
+    cout << "verified " << rounds << " persistent version histories" << endl;
+    return true;
 }
 
-// 从 n 到 m 生成质数并返回
-vector<int> generatePrimes(int n, int m) 
+// 随机插入、删除和批量并入,每步之后与有序数组核对;ConcurrentAVL单线程执行同样的操作,核对size和search
+bool verify(int rounds) 
 {
-    vector<int> primes = Eratosthenes(m);
-    // 筛选出 n, m 范围内的质数
-    vector<int> result;
-    for (int prime : primes) 
+    mt19937 rng(2024);
+    for (int round = 0; round < rounds; ++round) 
     {
-        if (prime >= n) 
+        int range = 1 + (int)(rng() % (round % 10 == 0 ? 5000 : 200));
+        AVLTree tree;
+        ConcurrentAVL shared;
+        vector<int> reference;
+        if (rng() % 4 == 0) 
         {
-            result.push_back(prime);
+            for (int x = 0; x <= range; ++x) 
+            {
+                if (rng() % 2) reference.push_back(x);
+            }
+            tree.buildFromSorted(reference);
+            for (int x : reference) shared.insert(x);
+        }
+        int steps = 1 + (int)(rng() % 100);
+        for (int step = 0; step < steps; ++step) 
+        {
+            int op = (int)(rng() % 10), x = (int)(rng() % (range + 1));
+            auto pos = lower_bound(reference.begin(), reference.end(), x);
+            if (op < 5) 
+            {
+                tree.insert(x);
+                shared.insert(x);
+                if (pos == reference.end() || *pos != x) reference.insert(pos, x);
+            } 
+            else if (op < 9) 
+            {
+                tree.deleteNode(x);
+                shared.deleteNode(x);
+                if (pos != reference.end() && *pos == x) reference.erase(pos);
+            } 
+            else 
+            {
+                vector<int> batch;
+                for (int y = 0; y <= range; ++y) 
+                {
+                    if (rng() % 8 == 0) batch.push_back(y);
+                }
+                tree.insertSorted(batch);
+                for (int y : batch) shared.insert(y);
+                vector<int> merged;
+                set_union(reference.begin(), reference.end(), batch.begin(), batch.end(), back_inserter(merged));
+                reference.swap(merged);
+            }
+            if (!sameAsReference(tree, reference, rng, range)) 
+            {
+                cerr << "第" << round << "轮第" << step << "步AVLTree与参考结果不一致" << endl;
+                return false;
+            }
+            if (shared.size() != reference.size() || shared.search(x) != binary_search(reference.begin(), reference.end(), x)) 
+            {
+                cerr << "第" << round << "轮第" << step << "步ConcurrentAVL与参考结果不一致" << endl;
+                return false;
+            }
         }
     }
-    return result;
+    cout << "verified " << rounds << " random sequences" << endl;
+    return verifyPersistent(rounds);
 }
-void writeQueryResults(const vector<int>& queries, Node* root, const string& filename) 
+
+// ConcurrentAVL的多线程压力测试:关键字按模4分类,
+// 4k一开始插入且永不删除,读者必须总能查到;4k+1从不插入,读者绝不能查到;
+// 4k+2和4k+3按编号分给各写者反复插入删除,结束后与每个写者自己的记录核对
+bool stress(int writers, int readers, int milliseconds) 
 {
-    ofstream outfile(filename);
-    for (int query : queries) 
+    const int KEYS = 1 << 16;
+    ConcurrentAVL tree;
+    for (int i = 0; i < KEYS; ++i) 
     {
-        outfile << query << " " << (search(root, query) ? "yes" : "no") << endl;
+        tree.insert(4 * i);
     }
-    outfile.close();
+
+    atomic<bool> stop(false);
+    atomic<long long> reads(0), writes(0), errors(0);
+    vector<vector<char>> present(writers, vector<char>(2 * KEYS, 0));
+    vector<thread> threads;
+    for (int w = 0; w < writers; ++w) 
+    {
+        threads.emplace_back([&, w] 
+        {
+            mt19937 rng(w + 1);
+            long long done = 0;
+            while (!stop.load(memory_order_relaxed)) 
+            {
+                int slot = (int)(rng() % (2 * KEYS / writers)) * writers + w;   // 第slot个可变关键字
+                int key = 4 * (slot / 2) + 2 + slot % 2;
+                if (present[w][slot]) tree.deleteNode(key);
+                else tree.insert(key);
+                present[w][slot] ^= 1;
+                ++done;
+            }
+            writes += done;
+        });
+    }
+    for (int r = 0; r < readers; ++r) 
+    {
+        threads.emplace_back([&, r] 
+        {
+            mt19937 rng(1000 + r);
+            long long done = 0, wrong = 0;
+            while (!stop.load(memory_order_relaxed)) 
+            {
+                int key = 4 * (int)(rng() % KEYS) + (int)(rng() % 4);
+                bool found = tree.search(key);
+                if ((key % 4 == 0 && !found) || (key % 4 == 1 && found)) ++wrong;
+                ++done;
+            }
+            reads += done;
+            errors += wrong;
+        });
+    }
+    this_thread::sleep_for(chrono::milliseconds(milliseconds));
+    stop = true;
+    for (thread& t : threads) 
+    {
+        t.join();
+    }
+
+    // 单线程核对最终状态
+    size_t expected = KEYS;
+    for (int slot = 0; slot < 2 * KEYS; ++slot) 
+    {
+        bool on = present[slot % writers][slot];
+        expected += on;
+        if (tree.search(4 * (slot / 2) + 2 + slot % 2) != on) ++errors;
+    }
+    if (tree.size() != expected) ++errors;
+    cout << writers << " writers, " << readers << " readers: " << reads << " reads, " << writes
+         << " writes, " << errors << " errors" << endl;
+    return errors == 0;
 }
 
-int main() {
+// 用法: 4 生成tree1~3.txt;4 --verify 随机核对AVLTree和ConcurrentAVL;
+// 4 --stress [写者数] [读者数] [毫秒] 多线程压力测试ConcurrentAVL
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--verify") == 0) 
+    {
+        return verify(2000) ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "--stress") == 0) 
+    {
+        int writers = argc > 2 ? max(atoi(argv[2]), 1) : 2;
+        int readers = argc > 3 ? max(atoi(argv[3]), 0) : 4;
+        int milliseconds = argc > 4 ? max(atoi(argv[4]), 1) : 2000;
+        return stress(writers, readers, milliseconds) ? 0 : 1;
+    }
+
     // 生成质数
     vector<int> primes = generatePrimes(0,10000);
 
     // 创建平衡二叉排序树并插入1-10000之间的质数
-    Node* root = nullptr;
+    AVLTree tree;
+    tree.buildFromSorted(primes);
+
+    // 持久化树同步执行同样的修改,用来保留删除之前的快照
+    PersistentAVL history;
+    PersistentAVL::Version current = history.empty();
     for (int prime : primes) 
     {
-        insert(root, prime);
+        current = history.insert(current, prime);
     }
 
     // (1) 查询200-300之间的质数
     vector<int> query1 =generatePrimes(200,300);
-    writeQueryResults(query1, root, "tree1.txt");
+    writeQueryResults(query1, tree, "tree1.txt");
 
     // (2) 删除500-2000之间的质数并查询600-700之间的质数
     vector<int> deletePrimes;
@@ -227,18 +364,26 @@ int main() {
             deletePrimes.push_back(prime);
         }
     }
+    PersistentAVL::Version beforeDelete = current;   // 删除前的快照,O(1)
     for (int prime : deletePrimes) 
     {
-        root = deleteNode(root, prime);
+        tree.deleteNode(prime);
+        current = history.deleteNode(current, prime);
     }
 
     vector<int> query2 = generatePrimes(600,700);
-    writeQueryResults(query2, root, "tree2.txt");
+    writeQueryResults(query2, tree, "tree2.txt");
 
     // (3) 插入1-1000之间的偶数并查询100-200之间的偶数
+    vector<int> evens;
     for (int i = 2; i <= 1000; i += 2) 
     {
-        insert(root, i);
+        evens.push_back(i);
+    }
+    tree.insertSorted(evens);
+    for (int even : evens) 
+    {
+        current = history.insert(current, even);
     }
 
     vector<int> query3;
@@ -246,7 +391,15 @@ int main() {
     {
         query3.push_back(i);
     }
-    writeQueryResults(query3, root, "tree3.txt");
+    writeQueryResults(query3, tree, "tree3.txt");
+
+    // (4) 删除和插入偶数之后,在删除前的快照中查询600-700之间的质数,结果写入tree4.txt
+    writeSnapshotResults(query2, history, beforeDelete, "tree4.txt");
+    if (history.inOrder(current) != tree.inOrder()) 
+    {
+        cerr << "持久化树的最新版本与AVL树不一致" << endl;
+        return 1;
+    }
 
     return 0;
 }
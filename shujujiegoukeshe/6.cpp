@@ -1,23 +1,53 @@
 #include<iostream>
 #include<algorithm>
 #include<cstring>
+#include<cstdio>
+#include<climits>
+#include<vector>
+#include<random>
+#ifdef __linux__
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#endif
 using namespace std;
 
-#define N 100
-int h[N], e[N], ne[N], w[N], idx;
 int n, m;
-bool visited[N]; 
+vector<bool> visited;
  // 记录节点是否被访问过
-int minTime = INT_MAX;  
+int minTime = INT_MAX;
 // 用来记录最小的最大施工时间
-void add(int a, int b, int c) {
-    e[idx] = b;
-    w[idx] = c;
-    ne[idx] = h[a];
-    h[a] = idx++;
+
+// 隧道,用于按施工时间排序
+struct Edge {
+    int a, b, c;
+};
+vector<Edge> edges;
+
+// CSR邻接表:节点u的邻居是e[h[u]] ~ e[h[u + 1] - 1],对应的施工时间在w中
+vector<int> h, e, w;
+
+// 由边表建立CSR:先数出每个节点的度数,前缀和得到起点,再把每条隧道的两个方向填进去
+void buildCSR() {
+    h.assign(n + 2, 0);
+    for (const Edge& edge : edges) {
+        h[edge.a + 1]++;
+        h[edge.b + 1]++;
+    }
+    for (int u = 1; u <= n + 1; u++) h[u] += h[u - 1];
+    e.resize(2 * edges.size());
+    w.resize(2 * edges.size());
+    vector<int> pos(h.begin(), h.end() - 1);
+    for (const Edge& edge : edges) {
+        e[pos[edge.a]] = edge.b;
+        w[pos[edge.a]++] = edge.c;
+        e[pos[edge.b]] = edge.a;
+        w[pos[edge.b]++] = edge.c;
+    }
 }
 
-// DFS 深度优先搜索
+// DFS 深度优先搜索:枚举所有简单路径,复杂度是指数级的,只用来在小数据上核对结果
 void dfs(int node, int currentMaxTime) {
     if (node == n) {
         minTime = min(minTime, currentMaxTime);
@@ -25,7 +55,7 @@ void dfs(int node, int currentMaxTime) {
     }
 
     // 遍历当前节点的所有邻接节点
-    for (int i = h[node]; i != -1; i = ne[i]) {
+    for (int i = h[node]; i < h[node + 1]; i++) {
         int neighbor = e[i];
         int time = w[i];
 
@@ -43,27 +73,665 @@ void dfs(int node, int currentMaxTime) {
     }
 }
 
-int main() {
-    memset(h, -1, sizeof(h));  // 初始化邻接表为空
-    memset(visited, false, sizeof(visited));  // 初始化访问标记为false
+// 并查集查找函数:路径减半,不递归
+int find(vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// 并查集合并函数:小集合挂到大集合下
+void unionSets(vector<int>& parent, vector<int>& size, int x, int y) {
+    x = find(parent, x);
+    y = find(parent, y);
+    if (x == y) return;
+    if (size[x] < size[y]) swap(x, y);
+    parent[y] = x;
+    size[x] += size[y];
+}
+
+// 最小的最大施工时间等于最小生成树上1到n路径中的最大边:
+// 按施工时间从小到大加入隧道,1和n第一次连通时加入的那条隧道就是答案,复杂度O(m log m)
+int bottleneck() {
+    if (n == 1) return 0;
+    vector<Edge> sorted = edges;
+    sort(sorted.begin(), sorted.end(), [](const Edge& x, const Edge& y) { return x.c < y.c; });
+    vector<int> parent(n + 1), size(n + 1, 1);
+    for (int i = 0; i <= n; i++) parent[i] = i;
+    for (const Edge& edge : sorted) {
+        unionSets(parent, size, edge.a, edge.b);
+        if (find(parent, 1) == find(parent, n)) return edge.c;
+    }
+    return INT_MAX;  // 1和n不连通
+}
+
+// Kruskal重构树:按施工时间从小到大加入隧道,每连通两个连通块就新建一个节点作为两块的根的父节点,
+// 新节点的权值是这条隧道的施工时间.枢纽1~n是叶子,新节点从n + 1开始编号,父节点的编号总比子节点大.
+// a到b最小的最大施工时间就是a和b在重构树上的最近公共祖先的权值;
+// 最近公共祖先用重链剖分来求,每次询问O(log n),额外内存只有几个长为2n的数组
+struct ReconstructionTree {
+    vector<int> parent, weight, depth, heavy, head, root;
+
+    void build() {
+        int total = 2 * n;
+        parent.assign(total, -1);
+        weight.assign(total, 0);
+        vector<Edge> sorted = edges;
+        sort(sorted.begin(), sorted.end(), [](const Edge& x, const Edge& y) { return x.c < y.c; });
+        // 枢纽上的并查集(按大小合并),treeTop记录每个连通块在重构树上的根
+        vector<int> group(n + 1), groupSize(n + 1, 1), treeTop(n + 1);
+        for (int i = 0; i <= n; i++) group[i] = treeTop[i] = i;
+        int next = n + 1;
+        for (const Edge& edge : sorted) {
+            int x = find(group, edge.a), y = find(group, edge.b);
+            if (x == y) continue;
+            parent[treeTop[x]] = parent[treeTop[y]] = next;
+            weight[next] = edge.c;
+            unionSets(group, groupSize, x, y);
+            treeTop[find(group, x)] = next++;
+            if (next == total) break;   // 已经连成一棵树
+        }
+
+        // 子节点编号小,按编号从小到大累加子树大小,同时记下每个节点最大的子树(重儿子)
+        vector<int> size(next, 1);
+        heavy.assign(next, -1);
+        for (int u = 1; u < next; u++) {
+            int p = parent[u];
+            if (p < 0) continue;
+            size[p] += size[u];
+            if (heavy[p] < 0 || size[u] > size[heavy[p]]) heavy[p] = u;
+        }
+        // 再从大到小给出深度、所在重链的链头和所在树的根
+        depth.assign(next, 0);
+        head.assign(next, 0);
+        root.assign(next, 0);
+        for (int u = next - 1; u >= 1; u--) {
+            int p = parent[u];
+            if (p < 0) {
+                head[u] = root[u] = u;
+            } else {
+                depth[u] = depth[p] + 1;
+                head[u] = heavy[p] == u ? head[p] : u;
+                root[u] = root[p];
+            }
+        }
+    }
+
+    int query(int a, int b) const {
+        if (a == b) return 0;
+        if (root[a] != root[b]) return INT_MAX;   // 不连通
+        while (head[a] != head[b]) {
+            if (depth[head[a]] < depth[head[b]]) swap(a, b);
+            a = parent[head[a]];
+        }
+        return weight[depth[a] < depth[b] ? a : b];
+    }
+};
+
+// Link-cut树:维护一个会变化的森林,支持连边、断边、判断连通以及查询路径上权值最大的节点,均摊O(log n).
+// 每棵实际的树按"偏好路径"拆成若干条链,每条链用一棵以深度为序的splay树表示,
+// splay树的根用up指向链顶的父节点(路径父指针);flip是子树翻转的懒标记,makeRoot换根时使用
+struct LinkCutTree {
+    vector<int> left, right, up;
+    vector<int> value;   // 节点的权值
+    vector<int> best;    // splay子树中权值最大的节点
+    vector<char> flip;
+    vector<int> pending;  // splay时自上而下下传标记用的栈
+
+    int addNode(int v) {
+        left.push_back(-1);
+        right.push_back(-1);
+        up.push_back(-1);
+        value.push_back(v);
+        best.push_back((int)value.size() - 1);
+        flip.push_back(0);
+        return (int)value.size() - 1;
+    }
+
+    bool isRoot(int x) const {
+        int p = up[x];
+        return p < 0 || (left[p] != x && right[p] != x);
+    }
+
+    void pull(int x) {
+        int b = x;
+        if (left[x] >= 0 && value[best[left[x]]] > value[b]) b = best[left[x]];
+        if (right[x] >= 0 && value[best[right[x]]] > value[b]) b = best[right[x]];
+        best[x] = b;
+    }
+
+    void push(int x) {
+        if (!flip[x]) return;
+        swap(left[x], right[x]);
+        if (left[x] >= 0) flip[left[x]] ^= 1;
+        if (right[x] >= 0) flip[right[x]] ^= 1;
+        flip[x] = 0;
+    }
+
+    void rotate(int x) {
+        int p = up[x], g = up[p];
+        if (!isRoot(p)) {
+            if (left[g] == p) left[g] = x;
+            else right[g] = x;
+        }
+        up[x] = g;
+        if (left[p] == x) {
+            left[p] = right[x];
+            if (right[x] >= 0) up[right[x]] = p;
+            right[x] = p;
+        } else {
+            right[p] = left[x];
+            if (left[x] >= 0) up[left[x]] = p;
+            left[x] = p;
+        }
+        up[p] = x;
+        pull(p);
+        pull(x);
+    }
+
+    void splay(int x) {
+        pending.clear();
+        for (int y = x; ; y = up[y]) {
+            pending.push_back(y);
+            if (isRoot(y)) break;
+        }
+        for (int i = (int)pending.size() - 1; i >= 0; i--) push(pending[i]);
+        while (!isRoot(x)) {
+            int p = up[x];
+            if (!isRoot(p)) {
+                int g = up[p];
+                rotate((left[g] == p) == (left[p] == x) ? p : x);
+            }
+            rotate(x);
+        }
+    }
+
+    // 让根到x成为一条偏好路径,结束时x是这条路径的splay树的根
+    void access(int x) {
+        int last = -1;
+        for (int y = x; y >= 0; y = up[y]) {
+            splay(y);
+            right[y] = last;
+            pull(y);
+            last = y;
+        }
+        splay(x);
+    }
+
+    void makeRoot(int x) {
+        access(x);
+        flip[x] ^= 1;
+        push(x);
+    }
+
+    int findRoot(int x) {
+        access(x);
+        while (true) {
+            push(x);
+            if (left[x] < 0) break;
+            x = left[x];
+        }
+        splay(x);
+        return x;
+    }
+
+    bool connected(int a, int b) {
+        return a == b || findRoot(a) == findRoot(b);
+    }
+
+    void link(int a, int b) {
+        makeRoot(a);
+        up[a] = b;
+    }
+
+    // 断开相邻的a和b
+    void cut(int a, int b) {
+        makeRoot(a);
+        access(b);
+        left[b] = -1;
+        up[a] = -1;
+        pull(b);
+    }
+
+    // a到b路径上权值最大的节点
+    int pathMax(int a, int b) {
+        makeRoot(a);
+        access(b);
+        return best[b];
+    }
+
+    void setValue(int x, int v) {
+        access(x);
+        value[x] = v;
+        pull(x);
+    }
+};
+
+// 动态维护最小生成森林,从而随时回答1到n的最小的最大施工时间.
+// 枢纽u对应link-cut树的节点u,第i条隧道对应节点n + 1 + i,隧道的施工时间就是这个节点的权值,
+// 这样路径上的最大边就是路径上权值最大的节点.
+// 加入隧道(或降低施工时间):端点不连通就直接连上;否则若路径上最大的隧道比它慢,换掉那条,均摊O(log n).
+// 提高生成森林中隧道的施工时间:断开后两边各自成树,新的生成森林应连上跨越两边的最快隧道(包括它自己).
+// 从两边同时按生成森林广度优先搜索,一边先搜完就只看这一边的枢纽连出去的隧道,
+// 代价与较小一边的大小和度数成正比;切掉的大多是靠近叶子的隧道,较小的一边通常很小
+struct DynamicBottleneck {
+    LinkCutTree tree;
+    vector<char> inTree;
+    vector<vector<int>> incident;   // 每个枢纽连着的所有隧道
+    vector<vector<int>> treeEdges;  // 每个枢纽连着的生成森林中的隧道
+    vector<unsigned> mark;          // 广度优先搜索的访问标记,2 * 代数 + 哪一边,不必每次清空
+    unsigned generation = 0;
+
+    int node(int edge) const { return n + 1 + edge; }
+
+    void build() {
+        for (int u = 0; u <= n; u++) tree.addNode(INT_MIN);
+        incident.assign(n + 1, vector<int>());
+        treeEdges.assign(n + 1, vector<int>());
+        mark.assign(n + 1, 0);
+        vector<int> order(edges.size());
+        for (size_t i = 0; i < edges.size(); i++) order[i] = (int)i;
+        sort(order.begin(), order.end(), [](int x, int y) { return edges[x].c < edges[y].c; });
+        for (size_t i = 0; i < edges.size(); i++) {
+            tree.addNode(edges[i].c);
+            inTree.push_back(0);
+            incident[edges[i].a].push_back((int)i);
+            if (edges[i].b != edges[i].a) incident[edges[i].b].push_back((int)i);
+        }
+
+        // 先用Kruskal求出初始的最小生成森林,再从每个连通块的一个枢纽出发定根,
+        // 直接把父指针写进link-cut树(每个节点自成一条偏好路径),不必逐条link
+        vector<int> group(n + 1), groupSize(n + 1, 1);
+        for (int u = 0; u <= n; u++) group[u] = u;
+        for (int i : order) {
+            int x = find(group, edges[i].a), y = find(group, edges[i].b);
+            if (x == y) continue;
+            unionSets(group, groupSize, x, y);
+            treeEdges[edges[i].a].push_back(i);
+            treeEdges[edges[i].b].push_back(i);
+            inTree[i] = 1;
+        }
+        vector<char> seen(n + 1, 0);
+        vector<int> queue;
+        for (int s = 1; s <= n; s++) {
+            if (seen[s]) continue;
+            seen[s] = 1;
+            queue.assign(1, s);
+            for (size_t head = 0; head < queue.size(); head++) {
+                int u = queue[head];
+                for (int j : treeEdges[u]) {
+                    int v = edges[j].a == u ? edges[j].b : edges[j].a;
+                    if (seen[v]) continue;
+                    seen[v] = 1;
+                    tree.up[v] = node(j);
+                    tree.up[node(j)] = u;
+                    queue.push_back(v);
+                }
+            }
+        }
+    }
+
+    void insert(int i) {
+        const Edge& edge = edges[i];
+        if (edge.a == edge.b) return;
+        if (!tree.connected(edge.a, edge.b)) {
+            attach(i);
+            return;
+        }
+        int heaviest = tree.pathMax(edge.a, edge.b);
+        if (tree.value[heaviest] > edge.c) {
+            detach(heaviest - n - 1);
+            attach(i);
+        }
+    }
+
+    void attach(int i) {
+        tree.link(edges[i].a, node(i));
+        tree.link(node(i), edges[i].b);
+        treeEdges[edges[i].a].push_back(i);
+        treeEdges[edges[i].b].push_back(i);
+        inTree[i] = 1;
+    }
+
+    void detach(int i) {
+        tree.cut(edges[i].a, node(i));
+        tree.cut(node(i), edges[i].b);
+        for (int u : {edges[i].a, edges[i].b}) {
+            vector<int>& list = treeEdges[u];
+            *find_if(list.begin(), list.end(), [i](int x) { return x == i; }) = list.back();
+            list.pop_back();
+        }
+        inTree[i] = 0;
+    }
+
+    // 新增一条隧道
+    void addEdge(int a, int b, int c) {
+        int i = (int)edges.size();
+        edges.push_back({a, b, c});
+        tree.addNode(c);
+        inTree.push_back(0);
+        incident[a].push_back(i);
+        if (b != a) incident[b].push_back(i);
+        insert(i);
+    }
+
+    // 修改第i条隧道的施工时间
+    void update(int i, int c) {
+        int old = edges[i].c;
+        edges[i].c = c;
+        tree.setValue(node(i), c);
+        if (!inTree[i]) {
+            insert(i);
+        } else if (c > old) {
+            detach(i);
+            attach(lightestCrossing(edges[i].a, edges[i].b));
+        }
+    }
+
+    // a和b分属断开后的两棵树,返回连接两棵树的最快隧道
+    int lightestCrossing(int a, int b) {
+        if (++generation > (UINT_MAX - 1) / 2) {   // 代数快要回绕时才真正清空
+            fill(mark.begin(), mark.end(), 0);
+            generation = 1;
+        }
+        vector<int> queue[2] = {{a}, {b}};
+        size_t head[2] = {0, 0};
+        mark[a] = 2 * generation;
+        mark[b] = 2 * generation + 1;
+        unsigned side = 0;
+        while (head[side] < queue[side].size()) {
+            int u = queue[side][head[side]++];
+            for (int j : treeEdges[u]) {
+                int v = edges[j].a == u ? edges[j].b : edges[j].a;
+                if (mark[v] != 2 * generation + side) {
+                    mark[v] = 2 * generation + side;
+                    queue[side].push_back(v);
+                }
+            }
+            if (head[side] == queue[side].size()) break;   // 这一边已经搜完
+            side ^= 1;
+        }
+
+        // 较小的一边已全部标记,看它连出去的非树隧道
+        int best = -1;
+        for (int u : queue[side]) {
+            for (int j : incident[u]) {
+                int v = edges[j].a == u ? edges[j].b : edges[j].a;
+                if (inTree[j] || mark[v] == 2 * generation + side) continue;
+                if (best < 0 || edges[j].c < edges[best].c) best = j;
+            }
+        }
+        return best;
+    }
+
+    int answer() {
+        if (n == 1) return 0;
+        if (!tree.connected(1, n)) return INT_MAX;
+        return tree.value[tree.pathMax(1, n)];
+    }
+};
+
+// 清空上一张图
+void init() {
+    visited.assign(n + 1, false);  // 初始化访问标记为false
+    edges.clear();
+    edges.reserve(m);
+    minTime = INT_MAX;
+}
+
+// 整个输入的只读视图:普通文件直接mmap,不拷贝;管道等无法映射的输入整体读入内存
+struct InputBuffer {
+    const char* data = nullptr;
+    size_t size = 0;
+    vector<char> owned;
+#ifdef __linux__
+    void* mapped = nullptr;
+#endif
+
+    bool open(const char* filename) {
+        FILE* file = filename ? fopen(filename, "rb") : stdin;
+        if (!file) return false;
+#ifdef __linux__
+        struct stat st;
+        if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                mapped = p;
+                data = (const char*)p;
+                size = st.st_size;
+                if (filename) fclose(file);
+                return true;
+            }
+        }
+#endif
+        char buffer[1 << 16];
+        size_t got;
+        while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            owned.insert(owned.end(), buffer, buffer + got);
+        }
+        if (filename) fclose(file);
+        data = owned.data();
+        size = owned.size();
+        return true;
+    }
+
+    ~InputBuffer() {
+#ifdef __linux__
+        if (mapped) munmap(mapped, size);
+#endif
+    }
+};
+
+// 手写的整数解析:跳过非数字字符,逐位累加;没有更多整数时返回false
+struct IntParser {
+    const char* p;
+    const char* end;
+
+    bool next(int& x) {
+        while (p < end && (*p < '0' || *p > '9') && *p != '-') p++;
+        if (p == end) return false;
+        bool negative = *p == '-';
+        if (negative) p++;
+        long long value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            p++;
+        }
+        x = (int)(negative ? -value : value);
+        return true;
+    }
+};
+
+// 在随机生成的小图上比较并查集解法和DFS
+bool verify(int rounds) {
+    mt19937 rng(2024);
+    for (int r = 0; r < rounds; r++) {
+        n = 1 + rng() % 8;
+        m = rng() % 14;
+        init();
+        for (int i = 0; i < m; i++) {
+            int a = 1 + rng() % n, b = 1 + rng() % n, c = 1 + rng() % 20;
+            edges.push_back({a, b, c});
+        }
+        buildCSR();
+        visited[1] = true;
+        dfs(1, 0);
+        ReconstructionTree tree;
+        tree.build();
+        if (bottleneck() != minTime || tree.query(1, n) != minTime) {
+            cout << "第" << r << "组不一致: n=" << n << " m=" << m << endl;
+            return false;
+        }
+        // 任意两点之间再用Floyd求最小的最大边核对一遍
+        vector<vector<int>> best(n + 1, vector<int>(n + 1, INT_MAX));
+        for (int u = 1; u <= n; u++) best[u][u] = 0;
+        for (const Edge& edge : edges) {
+            best[edge.a][edge.b] = best[edge.b][edge.a] = min(best[edge.a][edge.b], edge.c);
+        }
+        for (int k = 1; k <= n; k++)
+            for (int u = 1; u <= n; u++)
+                for (int v = 1; v <= n; v++)
+                    best[u][v] = min(best[u][v], max(best[u][k], best[k][v]));
+        for (int u = 1; u <= n; u++) {
+            for (int v = 1; v <= n; v++) {
+                if (tree.query(u, v) != best[u][v]) {
+                    cout << "第" << r << "组询问(" << u << ", " << v << ")不一致" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // 动态模式:随机加边、改施工时间,每一步都和重新跑一遍并查集解法比较
+    for (int r = 0; r < rounds / 10; r++) {
+        n = 1 + rng() % 10;
+        m = rng() % 12;
+        init();
+        for (int i = 0; i < m; i++) {
+            edges.push_back({1 + (int)(rng() % n), 1 + (int)(rng() % n), 1 + (int)(rng() % 30)});
+        }
+        DynamicBottleneck dynamic;
+        dynamic.build();
+        for (int step = 0; step < 30; step++) {
+            if (edges.empty() || rng() % 3 == 0) {
+                dynamic.addEdge(1 + rng() % n, 1 + rng() % n, 1 + rng() % 30);
+            } else {
+                dynamic.update(rng() % edges.size(), 1 + rng() % 30);
+            }
+            if (dynamic.answer() != bottleneck()) {
+                cout << "动态模式第" << r << "组第" << step << "步不一致" << endl;
+                return false;
+            }
+        }
+    }
+    cout << "verified " << rounds << " random graphs" << endl;
+    return true;
+}
+
+// 逐个回答询问文件中的(a, b),每行输出一个答案;不连通时输出INT_MAX,与单次询问一致
+bool answerQueries(const char* filename) {
+    InputBuffer input;
+    if (!input.open(filename)) {
+        cerr << "无法打开文件 " << filename << endl;
+        return false;
+    }
+    IntParser parser{input.data, input.data + input.size};
+    ReconstructionTree tree;
+    tree.build();
+
+    string out;
+    char digits[16];
+    int a, b;
+    while (parser.next(a) && parser.next(b)) {
+        if (a < 1 || a > n || b < 1 || b > n) {
+            out += "-1\n";   // 编号越界
+        } else {
+            int len = snprintf(digits, sizeof(digits), "%d\n", tree.query(a, b));
+            out.append(digits, len);
+        }
+        if (out.size() >= (1 << 16)) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    return true;
+}
+
+// 动态模式:依次执行更新文件中的操作,每个操作之后输出1到n当前的答案.
+// 操作"1 a b c"新增一条a到b、施工时间为c的隧道;"2 i c"把第i条隧道(按输入和新增的顺序从1编号)的时间改为c
+bool runUpdates(const char* filename) {
+    InputBuffer input;
+    if (!input.open(filename)) {
+        cerr << "无法打开文件 " << filename << endl;
+        return false;
+    }
+    IntParser parser{input.data, input.data + input.size};
+    DynamicBottleneck dynamic;
+    dynamic.build();
+
+    string out;
+    char digits[16];
+    int op;
+    while (parser.next(op)) {
+        int a, b, c;
+        if (op == 1 && parser.next(a) && parser.next(b) && parser.next(c) &&
+            a >= 1 && a <= n && b >= 1 && b <= n) {
+            dynamic.addEdge(a, b, c);
+        } else if (op == 2 && parser.next(a) && parser.next(c) && a >= 1 && a <= (int)edges.size()) {
+            dynamic.update(a - 1, c);
+        } else {
+            cerr << "更新文件格式错误" << endl;
+            break;
+        }
+        int len = snprintf(digits, sizeof(digits), "%d\n", dynamic.answer());
+        out.append(digits, len);
+        if (out.size() >= (1 << 16)) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    return true;
+}
+
+// 用法: 6 [输入文件] [询问文件]
+// 不给输入文件(或写作"-")时从标准输入读取;给出询问文件时建Kruskal重构树,回答其中每一对(a, b),
+// 否则只回答1到n;6 --dynamic 输入文件 更新文件: 动态模式;6 --verify: 用DFS核对各种解法
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--verify") == 0) {
+        return verify(20000) ? 0 : 1;
+    }
+    bool dynamic = argc > 1 && strcmp(argv[1], "--dynamic") == 0;
+    if (dynamic) {
+        argv++;
+        argc--;
+        if (argc < 3) {
+            cerr << "用法: 6 --dynamic 输入文件 更新文件" << endl;
+            return 1;
+        }
+    }
+
+    InputBuffer input;
+    if (!input.open(argc > 1 && strcmp(argv[1], "-") != 0 ? argv[1] : nullptr)) {
+        cerr << "无法打开文件 " << argv[1] << endl;
+        return 1;
+    }
+    IntParser parser{input.data, input.data + input.size};
 
     // 输入交通枢纽和隧道数目
-    cin >> n >> m;
+    if (!parser.next(n) || !parser.next(m) || n < 1 || m < 0) {
+        cerr << "输入格式错误" << endl;
+        return 1;
+    }
+    init();
 
     // 输入所有的隧道信息
     for (int i = 0; i < m; i++) {
         int a, b, c;
-        cin >> a >> b >> c;
-        add(a, b, c);
-        add(b, a, c);  
+        if (!parser.next(a) || !parser.next(b) || !parser.next(c)) {
+            cerr << "隧道数目不足" << m << "条" << endl;
+            return 1;
+        }
+        if (a < 1 || a > n || b < 1 || b > n) {
+            cerr << "第" << i + 1 << "条隧道的端点越界" << endl;
+            return 1;
+        }
+        edges.push_back({a, b, c});
     }
 
-
-    visited[1] = true;
-    dfs(1, 0);  // 从1号开始搜索，最大施工时间初始为0
+    if (dynamic) {
+        return runUpdates(argv[2]) ? 0 : 1;
+    }
+    if (argc > 2) {
+        return answerQueries(argv[2]) ? 0 : 1;
+    }
 
     // 输出最小的最大施工时间
-    cout << minTime << endl;
+    cout << bottleneck() << endl;
 
     return 0;
 }
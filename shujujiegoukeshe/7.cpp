@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <deque>
 #include <tuple>
 #include <algorithm>
 
@@ -24,12 +25,66 @@ struct Station {
     vector<Connection> connections;     // 相邻站点的连接信息
 };
 
-struct TransferState {
-    int stationId;
-    int currentLineId;
-    int transfers;
-    vector<int> path; // 路径记录
+// 查询用的紧凑线路图:站点ID映射为0..V-1的稠密下标,连接按CSR连续存放.
+// 转车查询的状态是(站点, 当前线路),也给每个站点经过的每条线路一个稠密下标,
+// 沿一条连接到达的状态在预处理时算好,BFS时不需要任何哈希查找
+struct BusGraph {
+    vector<int> stationIds;             // 下标 -> 站点ID
+    unordered_map<int, int> index;      // 站点ID -> 下标,只在查询入口使用
+    vector<int> offset;                 // 站点u的连接为[offset[u], offset[u + 1])
+    vector<int> target;                 // 连接到达的站点下标
+    vector<int> lineOf;                 // 连接所属线路ID
+    vector<int> targetState;            // 沿连接到达后的(站点, 线路)状态
+    vector<int> stateOffset;            // 站点u的状态为[stateOffset[u], stateOffset[u + 1])
+    vector<int> stateLine;              // 状态对应的线路ID,同一站点内升序
+    vector<int> stateStation;           // 状态对应的站点下标
+
+    int stationCount() const { return (int)stationIds.size(); }
+
+    // 站点ID对应的下标,不存在时返回-1
+    int find(int stationId) const {
+        auto it = index.find(stationId);
+        return it == index.end() ? -1 : it->second;
+    }
+
+    // 站点u经过线路lineId时的状态
+    int state(int u, int lineId) const {
+        auto first = stateLine.begin() + stateOffset[u], last = stateLine.begin() + stateOffset[u + 1];
+        return (int)(lower_bound(first, last, lineId) - stateLine.begin());
+    }
+};
+
+// 查询的工作区,多次查询共用.访问标记记录的是查询的代数,代数不同即视为未访问,
+// 所以每次查询不必清空数组;路径只记前驱,找到终点后再倒推出来
+struct BusSearch {
+    vector<unsigned> stamp;     // 站点或状态最近一次被访问时的代数
+    vector<int> parent;         // 前驱,起点为-1
+    vector<int> dist;           // 转车查询中到达该状态的最少转车次数
+    vector<int> queue;          // 经过站点最少查询的队列
+    deque<int> states;          // 转车查询的0-1 BFS双端队列
+    unsigned generation = 0;
+
+    // 开始新的一次查询,size为站点数或状态数
+    void reset(size_t size) {
+        if (stamp.size() < size) {
+            stamp.resize(size, 0);
+            parent.resize(size);
+            dist.resize(size);
+        }
+        if (++generation == 0) {   // 代数回绕时才真正清空
+            fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+    }
+
+    bool visited(int x) const { return stamp[x] == generation; }
+
+    void visit(int x, int from) {
+        stamp[x] = generation;
+        parent[x] = from;
+    }
 };
+
 /**
  *  从文件中读取公交线路数据并构建线路图
  *
@@ -93,86 +148,125 @@ bool readBusData(const string& filename, unordered_map<int, Station>& stations)
 }
 
 
+/**
+ *  把读入的站点映射转换为紧凑线路图
+ *
+ *  stations 所有站点的映射（站点ID -> Station）
+ *  返回按站点ID升序编号的BusGraph,每个站点的连接保持读入时的顺序
+ */
+BusGraph buildBusGraph(const unordered_map<int, Station>& stations) {
+    BusGraph graph;
+    for (const auto& entry : stations) {
+        graph.stationIds.push_back(entry.first);
+    }
+    sort(graph.stationIds.begin(), graph.stationIds.end());
+    int count = graph.stationCount();
+    graph.index.reserve(count);
+    for (int u = 0; u < count; ++u) {
+        graph.index[graph.stationIds[u]] = u;
+    }
+
+    graph.offset.assign(count + 1, 0);
+    graph.stateOffset.assign(count + 1, 0);
+    for (int u = 0; u < count; ++u) {
+        const Station& station = stations.at(graph.stationIds[u]);
+        graph.offset[u + 1] = graph.offset[u] + (int)station.connections.size();
+        graph.stateOffset[u + 1] = graph.stateOffset[u] + (int)station.lines.size();
+        vector<int> lines(station.lines.begin(), station.lines.end());
+        sort(lines.begin(), lines.end());
+        for (int lineId : lines) {
+            graph.stateLine.push_back(lineId);
+            graph.stateStation.push_back(u);
+        }
+    }
+
+    graph.target.reserve(graph.offset[count]);
+    graph.lineOf.reserve(graph.offset[count]);
+    for (int u = 0; u < count; ++u) {
+        for (const auto& conn : stations.at(graph.stationIds[u]).connections) {
+            graph.target.push_back(graph.index[conn.stationId]);
+            graph.lineOf.push_back(conn.lineId);
+        }
+    }
+    graph.targetState.resize(graph.target.size());
+    for (size_t k = 0; k < graph.target.size(); ++k) {
+        graph.targetState[k] = graph.state(graph.target[k], graph.lineOf[k]);
+    }
+    return graph;
+}
+
 /**
  *  查找转车次数最少的路线
  *
  *  startId 起始站点ID
  *  endId 终点站点ID
- *  stations 站点图
+ *  graph 紧凑线路图
+ *  search 查询工作区
  *  resultPath 结果路径
+ *  transfers 转车次数
  *  true 找到路径
  *  false 未找到路径
  */
-bool findMinTransfersPath(int startId, int endId, const unordered_map<int, Station>& stations, vector<int>& resultPath) {
-    if (stations.find(startId) == stations.end() || stations.find(endId) == stations.end()) {
+bool findMinTransfersPath(int startId, int endId, const BusGraph& graph, BusSearch& search,
+                          vector<int>& resultPath, int& transfers) {
+    int start = graph.find(startId), end = graph.find(endId);
+    if (start < 0 || end < 0) {
         cerr << "起始站点或终点站点不存在。" << endl;
         return false;
     }
 
-    // 使用队列进行BFS
-    queue<TransferState> q;
-
-    // 访问标记：stationId -> lineId -> 最小转车次数
-    unordered_map<int, unordered_map<int, int>> visited;
-
-    // 初始化队列：从起始站点出发，可以选择任何一条线路
-    for (const auto& line : stations.at(startId).lines) {
-        TransferState state;
-        state.stationId = startId;
-        state.currentLineId = line;
-        state.transfers = 0;
-        state.path.push_back(startId);
-        q.push(state);
-        visited[startId][line] = 0;
+    // 在(站点, 线路)状态上做0-1 BFS:沿同一条线路走代价为0,换乘代价为1,
+    // 不换乘的放队首,换乘的放队尾,出队顺序即转车次数的顺序,第一次出队到达终点就是最优
+    search.reset(graph.stateLine.size());
+    deque<int>& q = search.states;
+    q.clear();
+
+    // 从起始站点出发，可以选择任何一条线路
+    for (int s = graph.stateOffset[start]; s < graph.stateOffset[start + 1]; ++s) {
+        search.visit(s, -1);
+        search.dist[s] = 0;
+        q.push_back(s);
     }
 
+    int found = -1;
     while (!q.empty()) {
-        TransferState current = q.front();
-        q.pop();
-
-        // 如果到达终点，记录路径
-        if (current.stationId == endId) {
-            resultPath = current.path;
-            return true;
+        int current = q.front();
+        q.pop_front();
+        int u = graph.stateStation[current];
+        int currentLineId = graph.stateLine[current];
+
+        // 到达终点
+        if (u == end) {
+            found = current;
+            break;
         }
 
         // 遍历相邻站点
-        auto it = stations.find(current.stationId);
-        if (it == stations.end()) continue;
-
-        for (const auto& conn : it->second.connections) {
-            int neighborId = conn.stationId;
-            int lineId = conn.lineId;
-
-            // 判断是否需要转车
-            int newTransfers = current.transfers;
-            if (lineId != current.currentLineId) {
-                newTransfers += 1;
-            }
-
-            // 检查是否已经访问过，或者是否有更少的转车次数
-            if (visited.find(neighborId) != visited.end() &&
-                visited.at(neighborId).find(lineId) != visited.at(neighborId).end() &&
-                visited.at(neighborId).at(lineId) <= newTransfers) {
+        for (int k = graph.offset[u]; k < graph.offset[u + 1]; ++k) {
+            int transfer = graph.lineOf[k] != currentLineId;
+            int newTransfers = search.dist[current] + transfer;
+            int next = graph.targetState[k];
+            if (search.visited(next) && search.dist[next] <= newTransfers) {
                 continue;
             }
-
-            // 标记为已访问
-            visited[neighborId][lineId] = newTransfers;
-
-            // 记录路径
-            TransferState nextState;
-            nextState.stationId = neighborId;
-            nextState.currentLineId = lineId;
-            nextState.transfers = newTransfers;
-            nextState.path = current.path;
-            nextState.path.push_back(neighborId);
-            q.push(nextState);
+            search.visit(next, current);
+            search.dist[next] = newTransfers;
+            if (transfer) q.push_back(next);
+            else q.push_front(next);
         }
     }
+    if (found < 0) {
+        return false;   // 没有找到路径
+    }
 
-    // 如果没有找到路径
-    return false;
+    // 沿前驱倒推路径
+    transfers = search.dist[found];
+    resultPath.clear();
+    for (int s = found; s >= 0; s = search.parent[s]) {
+        resultPath.push_back(graph.stationIds[graph.stateStation[s]]);
+    }
+    reverse(resultPath.begin(), resultPath.end());
+    return true;
 }
 
 /**
@@ -180,48 +274,45 @@ bool findMinTransfersPath(int startId, int endId, const unordered_map<int, Stati
  *
  *  startId 起始站点ID
  *  endId 终点站点ID
- *  stations 站点图
+ *  graph 紧凑线路图
+ *  search 查询工作区
  *  resultPath 结果路径
  *  true 找到路径
  *  false 未找到路径
  */
-bool findMinStopsPath(int startId, int endId, const unordered_map<int, Station>& stations, vector<int>& resultPath) {
-    if (stations.find(startId) == stations.end() || stations.find(endId) == stations.end()) {
+bool findMinStopsPath(int startId, int endId, const BusGraph& graph, BusSearch& search, vector<int>& resultPath) {
+    int start = graph.find(startId), end = graph.find(endId);
+    if (start < 0 || end < 0) {
         cerr << "起始站点或终点站点不存在。" << endl;
         return false;
     }
 
-    // 使用队列进行BFS
-    queue<vector<int>> q;
-    unordered_set<int> visited;
-    visited.insert(startId);
-
-    // 初始化队列
-    q.push({startId});
-
-    while (!q.empty()) {
-        vector<int> path = q.front();
-        q.pop();
-
-        int currentStation = path.back();
-
-        // 如果到达终点，记录路径
-        if (currentStation == endId) {
-            resultPath = path;
+    // 使用队列进行BFS,数组模拟队列,只记录前驱
+    search.reset(graph.stationCount());
+    vector<int>& q = search.queue;
+    q.clear();
+    search.visit(start, -1);
+    q.push_back(start);
+
+    for (size_t head = 0; head < q.size(); ++head) {
+        int currentStation = q[head];
+
+        // 如果到达终点，沿前驱倒推路径
+        if (currentStation == end) {
+            resultPath.clear();
+            for (int v = end; v >= 0; v = search.parent[v]) {
+                resultPath.push_back(graph.stationIds[v]);
+            }
+            reverse(resultPath.begin(), resultPath.end());
             return true;
         }
 
         // 遍历相邻站点
-        auto it = stations.find(currentStation);
-        if (it == stations.end()) continue;
-
-        for (const auto& conn : it->second.connections) {
-            int neighborId = conn.stationId;
-            if (visited.find(neighborId) == visited.end()) {
-                visited.insert(neighborId);
-                vector<int> newPath = path;
-                newPath.push_back(neighborId);
-                q.push(newPath);
+        for (int k = graph.offset[currentStation]; k < graph.offset[currentStation + 1]; ++k) {
+            int neighbor = graph.target[k];
+            if (!search.visited(neighbor)) {
+                search.visit(neighbor, currentStation);
+                q.push_back(neighbor);
             }
         }
     }
@@ -239,6 +330,10 @@ int main() {
     if (!readBusData(filename, stations)) {
         return 1;  // 如果读取失败，退出程序
     }
+    // 预处理为紧凑线路图,之后的查询只用它
+    BusGraph graph = buildBusGraph(stations);
+    stations.clear();
+    BusSearch search;
 
     // 用户交互
     while (true) {
@@ -269,8 +364,9 @@ int main() {
         vector<int> path;
         if (choice == 1) {
             // 最少转车次数
-            if (findMinTransfersPath(startId, endId, stations, path)) {
-                cout << "转车次数最少的路线 (" << path.size() - 1 << " 次转车): ";
+            int transfers;
+            if (findMinTransfersPath(startId, endId, graph, search, path, transfers)) {
+                cout << "转车次数最少的路线 (" << transfers << " 次转车): ";
                 for (size_t i = 0; i < path.size(); ++i) {
                     cout << path[i];
                     if (i != path.size() - 1) cout << " -> ";
@@ -281,7 +377,7 @@ int main() {
             }
         } else if (choice == 2) {
             // 最少经过站点
-            if (findMinStopsPath(startId, endId, stations, path)) {
+            if (findMinStopsPath(startId, endId, graph, search, path)) {
                 cout << "经过站点最少的路线 (" << path.size() - 1 << " 个站点): ";
                 for (size_t i = 0; i < path.size(); ++i) {
                     cout << path[i];
@@ -0,0 +1,1018 @@
+#ifndef AVL_TREE_H
+#define AVL_TREE_H
+
+// 4.cpp使用的AVL树:节点池版AVLTree,以及并发版ConcurrentAVL和持久化版PersistentAVL
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <iterator>
+#include <atomic>
+#include <memory>
+#include <mutex>
+using namespace std;
+
+// AVL树的节点,统一存放在连续的节点池中,孩子用32位下标代替指针
+struct AVLNode {
+    int data;
+    int32_t left;    // 左孩子在节点池中的下标,-1表示空
+    int32_t right;   // 右孩子在节点池中的下标,-1表示空
+    int32_t size;    // 以该节点为根的子树中的关键字个数
+    int8_t height;   // 节点的高度
+};
+
+const int32_t NIL = -1;
+// AVL树高度不超过1.44*log2(n+2),int32下标最多约21亿个节点,64层的路径栈足够
+const int MAX_DEPTH = 64;
+
+// 基于节点池的AVL树,删除后空出的槽位会被后续插入复用
+struct AVLTree {
+    vector<AVLNode> pool;         // 节点池
+    int32_t root = NIL;        // 根节点下标
+    int32_t freeHead = NIL;    // 空闲槽位链表头,借用left串起来
+    size_t count = 0;          // 树中关键字个数
+
+    // 中序迭代器:栈中保存当前节点以及所有向左走过的祖先,
+    // 栈顶即当前节点,自顶向下关键字递增
+    class Iterator {
+    public:
+        Iterator() : tree(nullptr), top(0) {}
+        explicit Iterator(const AVLTree* t) : tree(t), top(0) {}
+
+        bool valid() const {
+            return top > 0;
+        }
+
+        int operator*() const {
+            return tree->pool[stack[top - 1]].data;
+        }
+
+        Iterator& operator++() {
+            int32_t node = tree->pool[stack[--top]].right;
+            pushLeft(node);
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            if (top == 0 || other.top == 0) return top == other.top;
+            return stack[top - 1] == other.stack[other.top - 1];
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+        // 从当前位置向后跳到第一个不小于value的关键字;
+        // 要求当前位置之前的关键字都小于value(例如迭代器本身是lower_bound(prev)且prev <= value)
+        void advanceTo(int value) {
+            int32_t last = NIL;
+            while (top > 0 && tree->pool[stack[top - 1]].data < value) {
+                last = stack[--top];
+            }
+            if (last != NIL) {
+                descend(tree->pool[last].right, value, false);
+            }
+        }
+
+    private:
+        friend struct AVLTree;
+        const AVLTree* tree;
+        int32_t stack[MAX_DEPTH];
+        int top;
+
+        void pushLeft(int32_t node) {
+            while (node != NIL) {
+                stack[top++] = node;
+                node = tree->pool[node].left;
+            }
+        }
+
+        // 从node向下查找第一个大于等于value(strict时为大于value)的关键字,沿途记录向左走过的节点
+        void descend(int32_t node, int value, bool strict) {
+            while (node != NIL) {
+                const AVLNode& n = tree->pool[node];
+                if (n.data > value || (!strict && n.data == value)) {
+                    stack[top++] = node;
+                    node = n.left;
+                } else {
+                    node = n.right;
+                }
+            }
+        }
+    };
+
+    // 预留节点池空间,避免插入过程中反复扩容
+    void reserve(size_t n) {
+        pool.reserve(n);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // 获取节点高度
+    int height(int32_t node) const {
+        return node == NIL ? -1 : pool[node].height;
+    }
+
+    // 更新节点的高度
+    void updateHeight(int32_t node) {
+        if (node == NIL) return;
+        pool[node].height = max(height(pool[node].left), height(pool[node].right)) + 1;
+    }
+
+    // 获取子树大小
+    int32_t subtreeSize(int32_t node) const {
+        return node == NIL ? 0 : pool[node].size;
+    }
+
+    // 由孩子重新计算子树大小
+    void updateSize(int32_t node) {
+        if (node == NIL) return;
+        pool[node].size = subtreeSize(pool[node].left) + subtreeSize(pool[node].right) + 1;
+    }
+
+    // 获取平衡因子
+    int balanceFactor(int32_t node) const {
+        return height(pool[node].left) - height(pool[node].right);
+    }
+
+    // 左旋操作,返回旋转后子树的根
+    int32_t leftRotate(int32_t node) {
+        int32_t child = pool[node].right;
+        if (child == NIL) return node;
+        pool[node].right = pool[child].left;
+        pool[child].left = node;
+        updateHeight(node);
+        updateHeight(child);
+        updateSize(node);
+        updateSize(child);
+        return child;
+    }
+
+    // 右旋操作,返回旋转后子树的根
+    int32_t rightRotate(int32_t node) {
+        int32_t child = pool[node].left;
+        pool[node].left = pool[child].right;
+        pool[child].right = node;
+        updateHeight(node);
+        updateHeight(child);
+        updateSize(node);
+        updateSize(child);
+        return child;
+    }
+
+    // 由递增序列直接建立完全平衡的AVL树,O(n);原有内容会被清空,相邻重复值只保留一个
+    void buildFromSorted(const vector<int>& keys) {
+        pool.clear();
+        pool.reserve(keys.size());
+        freeHead = NIL;
+        for (int key : keys) {
+            if (pool.empty() || key != pool.back().data) {
+                pool.push_back(AVLNode{key, NIL, NIL, 1, 0});
+            }
+        }
+        count = pool.size();
+        root = buildRange(0, (int32_t)pool.size());
+    }
+
+    // 把一批递增的关键字并入现有的树:批量较小时逐个插入,
+    // 否则把原树中序展开后与批量归并,再O(n+k)重建
+    void insertSorted(const vector<int>& keys) {
+        size_t n = count, k = keys.size();
+        size_t logn = 1;
+        while ((size_t(1) << logn) <= n) ++logn;
+        if (k * logn < n + k) {
+            for (int key : keys) {
+                insert(key);
+            }
+            return;
+        }
+        vector<int> merged;
+        merged.reserve(n + k);
+        vector<int> current = inOrder();
+        set_union(current.begin(), current.end(), keys.begin(), keys.end(), back_inserter(merged));
+        buildFromSorted(merged);
+    }
+
+    // 中序遍历得到递增的关键字序列
+    vector<int> inOrder() const {
+        vector<int> result;
+        result.reserve(count);
+        for (int key : *this) {
+            result.push_back(key);
+        }
+        return result;
+    }
+
+    // 插入操作:先沿路径下降并记录祖先,再自底向上回溯;
+    // 插入最多只需一次(单或双)旋转,旋转后或某祖先高度不变时即可提前结束
+    void insert(int value) {
+        int32_t path[MAX_DEPTH];
+        bool toLeft[MAX_DEPTH];
+        int depth = 0;
+        int32_t node = root;
+        while (node != NIL) {
+            const AVLNode& n = pool[node];
+            if (value == n.data) return;
+            path[depth] = node;
+            toLeft[depth] = value < n.data;
+            node = toLeft[depth] ? n.left : n.right;
+            ++depth;
+        }
+        // 确定会插入后,路径上每个祖先的子树都多一个节点;
+        // 子树大小在这里一次加好,后面回溯就可以在高度稳定时提前结束
+        for (int i = 0; i < depth; ++i) {
+            ++pool[path[i]].size;
+        }
+        setChild(path, toLeft, depth, newNode(value));
+
+        for (int i = depth - 1; i >= 0; --i) {
+            node = path[i];
+            int oldHeight = pool[node].height;
+            updateHeight(node);
+            int balance = balanceFactor(node);
+            if (balance > 1 || balance < -1) {
+                setChild(path, toLeft, i, rebalance(node));
+                break;
+            }
+            if (pool[node].height == oldHeight) break;
+        }
+    }
+
+    // 删除节点:有两个孩子时用右子树最小值替换后删除后继;
+    // 删除可能在多个祖先上触发旋转,直到某层子树高度不再变化为止
+    void deleteNode(int value) {
+        int32_t path[MAX_DEPTH];
+        bool toLeft[MAX_DEPTH];
+        int depth = 0;
+        int32_t node = root;
+        while (node != NIL && pool[node].data != value) {
+            path[depth] = node;
+            toLeft[depth] = value < pool[node].data;
+            node = toLeft[depth] ? pool[node].left : pool[node].right;
+            ++depth;
+        }
+        if (node == NIL) return;
+
+        if (pool[node].left != NIL && pool[node].right != NIL) {
+            int32_t target = node;
+            path[depth] = node;
+            toLeft[depth] = false;
+            ++depth;
+            node = pool[node].right;
+            while (pool[node].left != NIL) {
+                path[depth] = node;
+                toLeft[depth] = true;
+                ++depth;
+                node = pool[node].left;
+            }
+            pool[target].data = pool[node].data;
+        }
+        for (int i = 0; i < depth; ++i) {
+            --pool[path[i]].size;
+        }
+        int32_t child = pool[node].left != NIL ? pool[node].left : pool[node].right;
+        setChild(path, toLeft, depth, child);
+        freeNode(node);
+
+        for (int i = depth - 1; i >= 0; --i) {
+            node = path[i];
+            int oldHeight = pool[node].height;
+            updateHeight(node);
+            int balance = balanceFactor(node);
+            if (balance > 1 || balance < -1) {
+                node = rebalance(node);
+                setChild(path, toLeft, i, node);
+            }
+            if (pool[node].height == oldHeight) break;
+        }
+    }
+
+    // 查询节点
+    bool search(int value) const {
+        int32_t node = root;
+        while (node != NIL) {
+            const AVLNode& n = pool[node];
+            if (value == n.data) return true;
+            node = value < n.data ? n.left : n.right;
+        }
+        return false;
+    }
+
+    // 不大于value的关键字个数
+    size_t rank(int value) const {
+        size_t result = 0;
+        int32_t node = root;
+        while (node != NIL) {
+            const AVLNode& n = pool[node];
+            if (n.data <= value) {
+                result += subtreeSize(n.left) + 1;
+                node = n.right;
+            } else {
+                node = n.left;
+            }
+        }
+        return result;
+    }
+
+    // 小于value的关键字个数
+    size_t countLess(int value) const {
+        size_t result = 0;
+        int32_t node = root;
+        while (node != NIL) {
+            const AVLNode& n = pool[node];
+            if (n.data < value) {
+                result += subtreeSize(n.left) + 1;
+                node = n.right;
+            } else {
+                node = n.left;
+            }
+        }
+        return result;
+    }
+
+    // [lo, hi]内的关键字个数,O(log n)
+    size_t countRange(int lo, int hi) const {
+        if (lo > hi) return 0;
+        return rank(hi) - countLess(lo);
+    }
+
+    // 第k小的关键字(k从1开始),k越界时返回false
+    bool select(size_t k, int& result) const {
+        if (k == 0 || k > count) return false;
+        int32_t node = root;
+        while (true) {
+            const AVLNode& n = pool[node];
+            size_t leftSize = subtreeSize(n.left);
+            if (k <= leftSize) {
+                node = n.left;
+            } else if (k == leftSize + 1) {
+                result = n.data;
+                return true;
+            } else {
+                k -= leftSize + 1;
+                node = n.right;
+            }
+        }
+    }
+
+    // 百分位数(最近秩法):p取(0, 100],返回第ceil(p/100*n)小的关键字
+    bool percentile(double p, int& result) const {
+        if (p <= 0 || p > 100 || count == 0) return false;
+        size_t k = (size_t)ceil(p / 100.0 * count);
+        return select(min(max(k, size_t(1)), count), result);
+    }
+
+    Iterator begin() const {
+        Iterator it(this);
+        it.pushLeft(root);
+        return it;
+    }
+
+    Iterator end() const {
+        return Iterator(this);
+    }
+
+    // 第一个不小于value的位置
+    Iterator lower_bound(int value) const {
+        Iterator it(this);
+        it.descend(root, value, false);
+        return it;
+    }
+
+    // 第一个大于value的位置
+    Iterator upper_bound(int value) const {
+        Iterator it(this);
+        it.descend(root, value, true);
+        return it;
+    }
+
+    // 区间查询:按递增顺序返回[lo, hi]内的全部关键字,只下降一次,O(log n + k)
+    vector<int> rangeQuery(int lo, int hi) const {
+        vector<int> result;
+        for (Iterator it = lower_bound(lo); it.valid() && *it <= hi; ++it) {
+            result.push_back(*it);
+        }
+        return result;
+    }
+
+    // 批量查询:keys递增时,相邻两次查询复用迭代器栈中的公共路径,
+    // 只从两者分叉处重新下降;遇到比上一个小的关键字则从根重新开始
+    vector<bool> searchSorted(const vector<int>& keys) const {
+        vector<bool> found(keys.size());
+        Iterator it;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (i == 0 || keys[i] < keys[i - 1]) {
+                it = lower_bound(keys[i]);
+            } else {
+                it.advanceTo(keys[i]);
+            }
+            found[i] = it.valid() && *it == keys[i];
+        }
+        return found;
+    }
+
+private:
+    // 从空闲链表或池尾取一个槽位
+    int32_t newNode(int value) {
+        int32_t node;
+        if (freeHead != NIL) {
+            node = freeHead;
+            freeHead = pool[node].left;
+        } else {
+            node = (int32_t)pool.size();
+            pool.push_back(AVLNode());
+        }
+        pool[node] = AVLNode{value, NIL, NIL, 1, 0};
+        ++count;
+        return node;
+    }
+
+    // 归还槽位到空闲链表
+    void freeNode(int32_t node) {
+        pool[node].left = freeHead;
+        freeHead = node;
+        --count;
+    }
+
+    // 把pool[lo, hi)按中点递归连接成平衡子树,返回子树根;节点下标即中序序号
+    int32_t buildRange(int32_t lo, int32_t hi) {
+        if (lo >= hi) return NIL;
+        int32_t mid = lo + (hi - lo) / 2;
+        pool[mid].left = buildRange(lo, mid);
+        pool[mid].right = buildRange(mid + 1, hi);
+        updateHeight(mid);
+        updateSize(mid);
+        return mid;
+    }
+
+    // 把下标为depth的路径位置(即path[depth-1]的某个孩子,depth为0时是根)指向sub
+    void setChild(const int32_t* path, const bool* toLeft, int depth, int32_t sub) {
+        if (depth == 0) {
+            root = sub;
+        } else if (toLeft[depth - 1]) {
+            pool[path[depth - 1]].left = sub;
+        } else {
+            pool[path[depth - 1]].right = sub;
+        }
+    }
+
+    // 对失衡节点做旋转,返回旋转后子树的根
+    int32_t rebalance(int32_t node) {
+        int balance = balanceFactor(node);
+        if (balance > 1) {
+            // 左右情况先把左孩子左旋,转成左左情况
+            if (balanceFactor(pool[node].left) < 0) {
+                pool[node].left = leftRotate(pool[node].left);
+            }
+            return rightRotate(node);
+        }
+        if (balance < -1) {
+            // 右左情况先把右孩子右旋,转成右右情况
+            if (balanceFactor(pool[node].right) > 0) {
+                pool[node].right = rightRotate(pool[node].right);
+            }
+            return leftRotate(node);
+        }
+        return node;
+    }
+};
+
+// 并发AVL树的节点:读者不加锁,所以关键字和孩子下标用原子变量读写
+struct SharedNode {
+    atomic<int> data;
+    atomic<int32_t> left;
+    atomic<int32_t> right;
+    int8_t height;   // 只有持锁的写者会访问
+};
+
+// 读多写少场景下的并发AVL树:
+// 写者之间用互斥锁串行,修改树结构前后各把版本号加一(顺序锁),
+// 读者不加锁直接下降,结束后检查版本号没变才采用结果,否则重试;
+// 多次重试失败后退化为加锁查询,保证读者不会饿死.
+// 节点按段分配且段在析构前不释放,读者即使读到过期下标也不会访问非法内存.
+class ConcurrentAVL {
+public:
+    ConcurrentAVL() : segments(new atomic<SharedNode*>[MAX_SEGMENTS]()), root(NIL), version(0) {}
+
+    ~ConcurrentAVL() {
+        for (int32_t s = 0; s < MAX_SEGMENTS; ++s) {
+            delete[] segments[s].load(memory_order_relaxed);
+        }
+    }
+
+    ConcurrentAVL(const ConcurrentAVL&) = delete;
+    ConcurrentAVL& operator=(const ConcurrentAVL&) = delete;
+
+    size_t size() const {
+        lock_guard<mutex> guard(writeLock);
+        return count;
+    }
+
+    // 查询节点:先乐观地无锁查找,版本号校验通过即返回
+    bool search(int value) const {
+        for (int attempt = 0; attempt < OPTIMISTIC_RETRIES; ++attempt) {
+            uint64_t before = version.load(memory_order_acquire);
+            if (before & 1) continue;   // 有写者正在修改
+            bool found;
+            if (!tryOptimisticSearch(value, found)) continue;
+            atomic_thread_fence(memory_order_acquire);
+            if (version.load(memory_order_relaxed) == before) return found;
+        }
+        lock_guard<mutex> guard(writeLock);
+        int32_t node = root.load(memory_order_relaxed);
+        while (node != NIL) {
+            int key = at(node).data.load(memory_order_relaxed);
+            if (value == key) return true;
+            node = value < key ? left(node) : right(node);
+        }
+        return false;
+    }
+
+    // 插入操作,算法与AVLTree::insert相同
+    void insert(int value) {
+        lock_guard<mutex> guard(writeLock);
+        int32_t path[MAX_DEPTH];
+        bool toLeft[MAX_DEPTH];
+        int depth = 0;
+        int32_t node = root.load(memory_order_relaxed);
+        while (node != NIL) {
+            int key = at(node).data.load(memory_order_relaxed);
+            if (value == key) return;
+            path[depth] = node;
+            toLeft[depth] = value < key;
+            node = toLeft[depth] ? left(node) : right(node);
+            ++depth;
+        }
+        // 新节点在对读者可见之前就写好内容,不需要在版本号为奇数时做
+        int32_t fresh = newNode(value);
+
+        beginWrite();
+        setChild(path, toLeft, depth, fresh);
+        for (int i = depth - 1; i >= 0; --i) {
+            node = path[i];
+            int oldHeight = at(node).height;
+            updateHeight(node);
+            int balance = balanceFactor(node);
+            if (balance > 1 || balance < -1) {
+                setChild(path, toLeft, i, rebalance(node));
+                break;
+            }
+            if (at(node).height == oldHeight) break;
+        }
+        endWrite();
+    }
+
+    // 删除节点,算法与AVLTree::deleteNode相同
+    void deleteNode(int value) {
+        lock_guard<mutex> guard(writeLock);
+        int32_t path[MAX_DEPTH];
+        bool toLeft[MAX_DEPTH];
+        int depth = 0;
+        int32_t node = root.load(memory_order_relaxed);
+        while (node != NIL && at(node).data.load(memory_order_relaxed) != value) {
+            path[depth] = node;
+            toLeft[depth] = value < at(node).data.load(memory_order_relaxed);
+            node = toLeft[depth] ? left(node) : right(node);
+            ++depth;
+        }
+        if (node == NIL) return;
+
+        beginWrite();
+        if (left(node) != NIL && right(node) != NIL) {
+            int32_t target = node;
+            path[depth] = node;
+            toLeft[depth] = false;
+            ++depth;
+            node = right(node);
+            while (left(node) != NIL) {
+                path[depth] = node;
+                toLeft[depth] = true;
+                ++depth;
+                node = left(node);
+            }
+            at(target).data.store(at(node).data.load(memory_order_relaxed), memory_order_relaxed);
+        }
+        int32_t child = left(node) != NIL ? left(node) : right(node);
+        setChild(path, toLeft, depth, child);
+        freeNode(node);
+
+        for (int i = depth - 1; i >= 0; --i) {
+            node = path[i];
+            int oldHeight = at(node).height;
+            updateHeight(node);
+            int balance = balanceFactor(node);
+            if (balance > 1 || balance < -1) {
+                node = rebalance(node);
+                setChild(path, toLeft, i, node);
+            }
+            if (at(node).height == oldHeight) break;
+        }
+        endWrite();
+    }
+
+private:
+    static const int SEGMENT_BITS = 16;
+    static const int32_t SEGMENT_SIZE = 1 << SEGMENT_BITS;
+    static const int32_t MAX_SEGMENTS = 1 << (31 - SEGMENT_BITS);
+    static const int OPTIMISTIC_RETRIES = 8;
+
+    unique_ptr<atomic<SharedNode*>[]> segments;   // 段表,大小固定,段一旦分配就不移动
+    int32_t allocated = 0;                        // 已使用过的槽位数
+    int32_t freeHead = NIL;                       // 空闲槽位链表,借用left串起来
+    size_t count = 0;
+    atomic<int32_t> root;
+    atomic<uint64_t> version;                     // 偶数表示稳定,奇数表示正在修改
+    mutable mutex writeLock;
+
+    SharedNode& at(int32_t node) const {
+        return segments[node >> SEGMENT_BITS].load(memory_order_relaxed)[node & (SEGMENT_SIZE - 1)];
+    }
+
+    int32_t left(int32_t node) const {
+        return at(node).left.load(memory_order_relaxed);
+    }
+
+    int32_t right(int32_t node) const {
+        return at(node).right.load(memory_order_relaxed);
+    }
+
+    // 无锁下降一次;读到尚未发布的段或步数超过树高上限(读到了修改中的结构)时返回false
+    bool tryOptimisticSearch(int value, bool& found) const {
+        int32_t node = root.load(memory_order_relaxed);
+        for (int steps = 0; steps < MAX_DEPTH; ++steps) {
+            if (node == NIL) {
+                found = false;
+                return true;
+            }
+            SharedNode* segment = segments[node >> SEGMENT_BITS].load(memory_order_acquire);
+            if (segment == nullptr) return false;
+            const SharedNode& n = segment[node & (SEGMENT_SIZE - 1)];
+            int key = n.data.load(memory_order_relaxed);
+            if (value == key) {
+                found = true;
+                return true;
+            }
+            node = value < key ? n.left.load(memory_order_relaxed) : n.right.load(memory_order_relaxed);
+        }
+        return false;
+    }
+
+    void beginWrite() {
+        version.store(version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+
+    void endWrite() {
+        version.store(version.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    int32_t newNode(int value) {
+        int32_t node;
+        if (freeHead != NIL) {
+            node = freeHead;
+            freeHead = left(node);
+        } else {
+            node = allocated++;
+            int32_t s = node >> SEGMENT_BITS;
+            if (segments[s].load(memory_order_relaxed) == nullptr) {
+                segments[s].store(new SharedNode[SEGMENT_SIZE](), memory_order_release);
+            }
+        }
+        SharedNode& n = at(node);
+        n.data.store(value, memory_order_relaxed);
+        n.left.store(NIL, memory_order_relaxed);
+        n.right.store(NIL, memory_order_relaxed);
+        n.height = 0;
+        ++count;
+        return node;
+    }
+
+    // 被释放的槽位可能仍有读者在访问,它们会因为版本号变化而重试
+    void freeNode(int32_t node) {
+        at(node).left.store(freeHead, memory_order_relaxed);
+        freeHead = node;
+        --count;
+    }
+
+    int height(int32_t node) const {
+        return node == NIL ? -1 : at(node).height;
+    }
+
+    void updateHeight(int32_t node) {
+        at(node).height = max(height(left(node)), height(right(node))) + 1;
+    }
+
+    int balanceFactor(int32_t node) const {
+        return height(left(node)) - height(right(node));
+    }
+
+    int32_t leftRotate(int32_t node) {
+        int32_t child = right(node);
+        at(node).right.store(left(child), memory_order_relaxed);
+        at(child).left.store(node, memory_order_relaxed);
+        updateHeight(node);
+        updateHeight(child);
+        return child;
+    }
+
+    int32_t rightRotate(int32_t node) {
+        int32_t child = left(node);
+        at(node).left.store(right(child), memory_order_relaxed);
+        at(child).right.store(node, memory_order_relaxed);
+        updateHeight(node);
+        updateHeight(child);
+        return child;
+    }
+
+    int32_t rebalance(int32_t node) {
+        int balance = balanceFactor(node);
+        if (balance > 1) {
+            if (balanceFactor(left(node)) < 0) {
+                at(node).left.store(leftRotate(left(node)), memory_order_relaxed);
+            }
+            return rightRotate(node);
+        }
+        if (balance < -1) {
+            if (balanceFactor(right(node)) > 0) {
+                at(node).right.store(rightRotate(right(node)), memory_order_relaxed);
+            }
+            return leftRotate(node);
+        }
+        return node;
+    }
+
+    void setChild(const int32_t* path, const bool* toLeft, int depth, int32_t sub) {
+        if (depth == 0) {
+            root.store(sub, memory_order_relaxed);
+        } else if (toLeft[depth - 1]) {
+            at(path[depth - 1]).left.store(sub, memory_order_relaxed);
+        } else {
+            at(path[depth - 1]).right.store(sub, memory_order_relaxed);
+        }
+    }
+};
+
+// 持久化(路径复制)AVL树:插入/删除不修改旧版本,只复制根到修改点路径上的节点,
+// 返回新版本的根,未改动的子树在各版本之间共享.
+// 节点带引用计数(父节点的链接和Version句柄各算一个),引用计数为1的节点只被当前操作持有,
+// 可以原地修改;版本释放后引用计数归零的节点回到空闲链表复用.
+class PersistentAVL {
+public:
+    // 某个版本的句柄,复制即创建快照(O(1)),析构时释放该版本独占的节点
+    class Version {
+    public:
+        Version() : owner(nullptr), root(NIL) {}
+
+        Version(const Version& other) : owner(other.owner), root(other.root) {
+            if (owner) owner->retain(root);
+        }
+
+        Version(Version&& other) noexcept : owner(other.owner), root(other.root) {
+            other.owner = nullptr;
+            other.root = NIL;
+        }
+
+        Version& operator=(Version other) {
+            swap(owner, other.owner);
+            swap(root, other.root);
+            return *this;
+        }
+
+        ~Version() {
+            if (owner) owner->release(root);
+        }
+
+    private:
+        friend class PersistentAVL;
+        // 接管一个已经计入引用计数的根
+        Version(PersistentAVL* t, int32_t r) : owner(t), root(r) {}
+
+        PersistentAVL* owner;
+        int32_t root;
+    };
+
+    PersistentAVL() = default;
+    PersistentAVL(const PersistentAVL&) = delete;
+    PersistentAVL& operator=(const PersistentAVL&) = delete;
+
+    // 空树版本
+    Version empty() {
+        return Version(this, NIL);
+    }
+
+    // 插入操作,返回新版本;关键字已存在时返回同一版本的快照
+    Version insert(const Version& version, int value) {
+        if (search(version, value)) return version;
+        retain(version.root);
+        return Version(this, insertAt(version.root, value));
+    }
+
+    // 删除节点,返回新版本;关键字不存在时返回同一版本的快照
+    Version deleteNode(const Version& version, int value) {
+        if (!search(version, value)) return version;
+        retain(version.root);
+        return Version(this, deleteAt(version.root, value));
+    }
+
+    // 查询节点
+    bool search(const Version& version, int value) const {
+        int32_t node = version.root;
+        while (node != NIL) {
+            const PNode& n = pool[node];
+            if (value == n.data) return true;
+            node = value < n.data ? n.left : n.right;
+        }
+        return false;
+    }
+
+    // 中序遍历某个版本
+    vector<int> inOrder(const Version& version) const {
+        vector<int> result;
+        int32_t stack[MAX_DEPTH];
+        int top = 0;
+        int32_t node = version.root;
+        while (node != NIL || top > 0) {
+            while (node != NIL) {
+                stack[top++] = node;
+                node = pool[node].left;
+            }
+            node = stack[--top];
+            result.push_back(pool[node].data);
+            node = pool[node].right;
+        }
+        return result;
+    }
+
+    // 所有存活版本共占用的节点数
+    size_t liveNodes() const {
+        return live;
+    }
+
+    // 检查某个版本每个节点的高度字段是否正确、平衡因子是否不超过1
+    bool balanced(const Version& version) const {
+        int h;
+        return checkHeight(version.root, h);
+    }
+
+private:
+    struct PNode {
+        int data;
+        int32_t left;
+        int32_t right;
+        int32_t refs;    // 引用计数
+        int8_t height;
+    };
+
+    vector<PNode> pool;
+    int32_t freeHead = NIL;
+    size_t live = 0;
+
+    int32_t alloc(int value, int32_t left, int32_t right, int8_t height) {
+        int32_t node;
+        if (freeHead != NIL) {
+            node = freeHead;
+            freeHead = pool[node].left;
+        } else {
+            node = (int32_t)pool.size();
+            pool.push_back(PNode());
+        }
+        pool[node] = PNode{value, left, right, 1, height};
+        ++live;
+        return node;
+    }
+
+    void retain(int32_t node) {
+        if (node != NIL) ++pool[node].refs;
+    }
+
+    // 引用计数归零时回收节点,并释放它对两个孩子的引用
+    void release(int32_t node) {
+        while (node != NIL && --pool[node].refs == 0) {
+            int32_t left = pool[node].left;
+            int32_t right = pool[node].right;
+            pool[node].left = freeHead;
+            freeHead = node;
+            --live;
+            release(left);
+            node = right;
+        }
+    }
+
+    // 取得node的独占副本:调用者交出自己持有的一个引用,换回一个可以原地修改的节点
+    int32_t own(int32_t node) {
+        if (pool[node].refs == 1) return node;
+        PNode n = pool[node];
+        retain(n.left);
+        retain(n.right);
+        --pool[node].refs;
+        return alloc(n.data, n.left, n.right, n.height);
+    }
+
+    int height(int32_t node) const {
+        return node == NIL ? -1 : pool[node].height;
+    }
+
+    bool checkHeight(int32_t node, int& h) const {
+        if (node == NIL) {
+            h = -1;
+            return true;
+        }
+        int left, right;
+        if (!checkHeight(pool[node].left, left) || !checkHeight(pool[node].right, right)) return false;
+        h = max(left, right) + 1;
+        return pool[node].height == h && abs(left - right) <= 1;
+    }
+
+    void updateHeight(int32_t node) {
+        pool[node].height = max(height(pool[node].left), height(pool[node].right)) + 1;
+    }
+
+    int balanceFactor(int32_t node) const {
+        return height(pool[node].left) - height(pool[node].right);
+    }
+
+    // 旋转前先取得孩子的独占副本,旋转只移动链接,不改变任何节点的引用计数
+    int32_t leftRotate(int32_t node) {
+        int32_t child = own(pool[node].right);
+        pool[node].right = pool[child].left;
+        pool[child].left = node;
+        updateHeight(node);
+        updateHeight(child);
+        return child;
+    }
+
+    int32_t rightRotate(int32_t node) {
+        int32_t child = own(pool[node].left);
+        pool[node].left = pool[child].right;
+        pool[child].right = node;
+        updateHeight(node);
+        updateHeight(child);
+        return child;
+    }
+
+    int32_t rebalance(int32_t node) {
+        int balance = balanceFactor(node);
+        if (balance > 1) {
+            if (balanceFactor(pool[node].left) < 0) {
+                int32_t child = own(pool[node].left);
+                pool[node].left = leftRotate(child);
+            }
+            return rightRotate(node);
+        }
+        if (balance < -1) {
+            if (balanceFactor(pool[node].right) > 0) {
+                int32_t child = own(pool[node].right);
+                pool[node].right = rightRotate(child);
+            }
+            return leftRotate(node);
+        }
+        return node;
+    }
+
+    // 调用者交出node的一个引用,返回插入后子树的根(引用同样交给调用者);value保证不在子树中
+    int32_t insertAt(int32_t node, int value) {
+        if (node == NIL) return alloc(value, NIL, NIL, 0);
+        node = own(node);
+        if (value < pool[node].data) {
+            int32_t child = insertAt(pool[node].left, value);
+            pool[node].left = child;
+        } else {
+            int32_t child = insertAt(pool[node].right, value);
+            pool[node].right = child;
+        }
+        updateHeight(node);
+        return rebalance(node);
+    }
+
+    // 引用约定同insertAt;value保证在子树中
+    int32_t deleteAt(int32_t node, int value) {
+        node = own(node);
+        if (value < pool[node].data) {
+            int32_t child = deleteAt(pool[node].left, value);
+            pool[node].left = child;
+        } else if (value > pool[node].data) {
+            int32_t child = deleteAt(pool[node].right, value);
+            pool[node].right = child;
+        } else if (pool[node].left == NIL || pool[node].right == NIL) {
+            // 把唯一的孩子(连同引用)交给调用者,再回收当前节点
+            int32_t child = pool[node].left != NIL ? pool[node].left : pool[node].right;
+            pool[node].left = pool[node].right = NIL;
+            release(node);
+            return child;
+        } else {
+            int32_t successor = pool[node].right;
+            while (pool[successor].left != NIL) {
+                successor = pool[successor].left;
+            }
+            pool[node].data = pool[successor].data;
+            int32_t child = deleteAt(pool[node].right, pool[node].data);
+            pool[node].right = child;
+        }
+        updateHeight(node);
+        return rebalance(node);
+    }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// tree_bench.cpp和huffman_bench.cpp共用的测量工具:
+// 每次运行放在单独的子进程里,结果通过管道整体传回,这样各次运行的峰值内存互不影响;
+// 非Linux平台直接在本进程中运行,内存统计为0
+#include <cstdio>
+#include <cstddef>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+using namespace std;
+
+// 当前进程的常驻内存(字节)
+inline size_t currentRSS() {
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long pages = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+// 本进程到目前为止的峰值常驻内存(字节)
+inline size_t peakRSS() {
+#ifdef __linux__
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t)usage.ru_maxrss * 1024;
+#else
+    return 0;
+#endif
+}
+
+// 在子进程中执行run()并取回它返回的结果;Result必须能按字节拷贝
+template <class Result, class Run>
+bool runIsolated(Result& result, Run run) {
+#ifdef __linux__
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        Result r = run();
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+    result = run();
+    return true;
+#endif
+}
+
+#endif
@@ -0,0 +1,959 @@
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+// 5.cpp使用的Huffman编解码:范式编码、限长码、digram字母表、分块并行的code.dat格式
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// 编码用的字母表:符号0~255是单个字节,256起是从原文中挑出的常见双字节组合(digram),
+// 一个digram符号解码时一次输出两个字节
+const int MAX_DIGRAMS = 256;
+const int MAX_SYMBOLS = 256 + MAX_DIGRAMS;
+
+// 定义Huffman树节点;节点都放在HuffmanTree的数组里,用下标代替指针
+struct HuffmanNode {
+    int16_t ch;            // 存储符号
+    uint64_t frequency;    // 字符频率
+    int16_t left;          // 左子节点下标,-1表示没有
+    int16_t right;         // 右子节点下标,-1表示没有
+};
+
+// MAX_SYMBOLS个叶子加上至多MAX_SYMBOLS - 1个内部节点,整棵树放在一个固定大小的数组里,不需要new/delete
+const int MAX_TREE_NODES = 2 * MAX_SYMBOLS - 1;
+
+struct HuffmanTree {
+    array<HuffmanNode, MAX_TREE_NODES> nodes;
+    int count = 0;    // 已使用的节点数
+    int root = -1;    // 根节点下标,空文件时为-1
+};
+
+typedef array<uint64_t, MAX_SYMBOLS> FrequencyTable;
+
+// 统计一段数据中各字节出现的次数并累加到freq的前256项中.
+// 连续的相同字节会反复读改写同一个计数器,每次都要等上一次的存储转发完成;
+// 这里把第i个字节计到第i % 8组计数器里,相邻字节落在不同组,依赖链被拆开.
+// 计数器只用16位,8组一共4KB,能留在L1缓存中;每处理8 * 65535字节就把各组累加到freq并清零,不会溢出
+const int HISTOGRAM_LANES = 8;
+const size_t HISTOGRAM_SPILL = HISTOGRAM_LANES * 65535;
+
+inline void countBytes(const char* data, size_t size, FrequencyTable& freq) {
+    uint16_t counts[HISTOGRAM_LANES][256];
+    while (size > 0) {
+        size_t chunk = min(size, HISTOGRAM_SPILL);
+        memset(counts, 0, sizeof(counts));
+        size_t i = 0;
+        for (; i + 8 <= chunk; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            counts[0][word & 0xFF]++;
+            counts[1][(word >> 8) & 0xFF]++;
+            counts[2][(word >> 16) & 0xFF]++;
+            counts[3][(word >> 24) & 0xFF]++;
+            counts[4][(word >> 32) & 0xFF]++;
+            counts[5][(word >> 40) & 0xFF]++;
+            counts[6][(word >> 48) & 0xFF]++;
+            counts[7][word >> 56]++;
+        }
+        for (; i < chunk; ++i) {
+            counts[i & 7][(unsigned char)data[i]]++;
+        }
+        for (int ch = 0; ch < 256; ++ch) {
+            uint64_t sum = 0;
+            for (int lane = 0; lane < HISTOGRAM_LANES; ++lane) sum += counts[lane][ch];
+            freq[ch] += sum;
+        }
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+// 构建Huffman树
+// 叶子按频率排好序后,新合并出的内部节点频率单调不减,它们在数组里也是按生成顺序排列的;
+// 于是叶子和内部节点各自构成一个有序队列,每次从两个队头里取较小者即可,不需要堆
+inline HuffmanTree build(const FrequencyTable& freq) {
+    HuffmanTree tree;
+    HuffmanNode* nodes = tree.nodes.data();
+
+    // 将每个出现过的字符作为叶子放入数组,按频率从小到大排序
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (freq[ch] > 0) {
+            nodes[tree.count++] = HuffmanNode{(int16_t)ch, freq[ch], -1, -1};
+        }
+    }
+    int leaves = tree.count;
+    if (leaves == 0) return tree;   // 空文件
+    stable_sort(nodes, nodes + leaves, [](const HuffmanNode& a, const HuffmanNode& b) {
+        return a.frequency < b.frequency;
+    });
+
+    // 反复取出频率最小的两个节点合并
+    int leaf = 0, inner = leaves;
+    auto takeMin = [&]() {
+        if (leaf < leaves && (inner == tree.count || nodes[leaf].frequency <= nodes[inner].frequency)) {
+            return leaf++;
+        }
+        return inner++;
+    };
+    while (tree.count < 2 * leaves - 1) {
+        int left = takeMin();
+        int right = takeMin();
+        nodes[tree.count++] = HuffmanNode{-1, nodes[left].frequency + nodes[right].frequency,
+                                          (int16_t)left, (int16_t)right};
+    }
+    tree.root = tree.count - 1;
+    return tree;
+}
+
+// 每个字符的编码:bits的低len位,高位在前;len为0表示该字符没有出现
+struct HuffmanCode {
+    uint64_t bits;
+    int len;
+};
+
+typedef array<HuffmanCode, MAX_SYMBOLS> CodeTable;
+
+typedef array<uint8_t, MAX_SYMBOLS> CodeLengths;
+
+// 为每个字符生成Huffman编码:父节点的下标总比子节点大,从根开始按下标从大到小扫一遍,
+// 就能把码字和码长逐层传给子节点,不需要递归和字符串拼接.
+// 码字只保留低64位,超过64位的码长由limitCodeLengths截短后再由canonicalCodes重新分配码字
+inline CodeTable generate(const HuffmanTree& tree) {
+    CodeTable codes;
+    codes.fill(HuffmanCode{0, 0});
+    if (tree.root < 0) return codes;
+    array<HuffmanCode, MAX_TREE_NODES> path;
+    path[tree.root] = HuffmanCode{0, 0};
+    for (int i = tree.root; i >= 0; --i) {
+        const HuffmanNode& node = tree.nodes[i];
+        if (node.left < 0) {
+            codes[node.ch] = path[i];
+            continue;
+        }
+        path[node.left] = HuffmanCode{path[i].bits << 1, path[i].len + 1};
+        path[node.right] = HuffmanCode{path[i].bits << 1 | 1, path[i].len + 1};
+    }
+    // 只有一种字符时根就是叶子,编码为空串,约定用1位的"0"表示
+    if (tree.nodes[tree.root].left < 0) {
+        codes[tree.nodes[tree.root].ch] = HuffmanCode{0, 1};
+    }
+    return codes;
+}
+
+// 从Huffman编码中只取码长,具体码字由canonicalCodes重新分配
+inline CodeLengths codeLengths(const CodeTable& huffmanCodes) {
+    CodeLengths lengths;
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        lengths[ch] = (uint8_t)huffmanCodes[ch].len;
+    }
+    return lengths;
+}
+
+// 码长上限的默认值和允许范围:MAX_SYMBOLS种符号至少要9位;不超过ROOT_BITS + SUB_BITS时解码任何符号至多查两次表
+const int DEFAULT_MAX_CODE_LENGTH = 15;
+const int MIN_CODE_LENGTH_LIMIT = 9;
+
+// 限制码长:Huffman树上最长的码超过maxLength时,改用package-merge算法重新计算码长,
+// 得到所有码长都不超过maxLength的前提下总编码长度最小的一组.
+// 字符按频率从小到大排好,最深一层的列表就是这些字符;往上每一层把下一层的列表两两打包,
+// 再和字符按权重归并.最上层取前2n-2项,之后每层被选中的包恰好对应下一层的前若干项,
+// 每个字符在各层被选中几次,码长就是几
+inline void limitCodeLengths(CodeLengths& lengths, const FrequencyTable& freq, int maxLength) {
+    vector<int> symbols;
+    int longest = 0;
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (lengths[ch] > 0) {
+            symbols.push_back(ch);
+            longest = max(longest, (int)lengths[ch]);
+        }
+    }
+    if (longest <= maxLength || symbols.size() < 2) return;
+    stable_sort(symbols.begin(), symbols.end(), [&](int a, int b) { return freq[a] < freq[b]; });
+
+    struct Item {
+        uint64_t weight;
+        int symbol;   // 小于0表示包
+    };
+    vector<vector<Item>> levels(maxLength);   // levels[d]对应第d + 1位
+    for (int ch : symbols) {
+        levels[maxLength - 1].push_back(Item{freq[ch], ch});
+    }
+    for (int d = maxLength - 2; d >= 0; --d) {
+        const vector<Item>& below = levels[d + 1];
+        vector<Item>& level = levels[d];
+        size_t leaf = 0, pair = 0;
+        while (leaf < symbols.size() || pair + 1 < below.size()) {
+            uint64_t packed = pair + 1 < below.size() ? below[pair].weight + below[pair + 1].weight : 0;
+            if (pair + 1 >= below.size() || (leaf < symbols.size() && freq[symbols[leaf]] <= packed)) {
+                level.push_back(Item{freq[symbols[leaf]], symbols[leaf]});
+                ++leaf;
+            } else {
+                level.push_back(Item{packed, -1});
+                pair += 2;
+            }
+        }
+    }
+
+    for (int ch : symbols) lengths[ch] = 0;
+    size_t take = 2 * symbols.size() - 2;
+    for (int d = 0; d < maxLength && take > 0; ++d) {
+        size_t packages = 0;
+        for (size_t i = 0; i < take; ++i) {
+            if (levels[d][i].symbol >= 0) {
+                lengths[levels[d][i].symbol]++;
+            } else {
+                ++packages;
+            }
+        }
+        take = 2 * packages;
+    }
+}
+
+// 范式Huffman编码:按(码长, 字符)排序后依次分配连续的码字,
+// 码长相同的码字连续递增,换到更长的码长时左移补0;解码端只需码长即可还原整张编码表
+inline CodeTable canonicalCodes(const CodeLengths& lengths) {
+    CodeTable codes;
+    codes.fill(HuffmanCode{0, 0});
+    vector<int> symbols;
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (lengths[ch] > 0) symbols.push_back(ch);
+    }
+    stable_sort(symbols.begin(), symbols.end(), [&](int a, int b) { return lengths[a] < lengths[b]; });
+    uint64_t code = 0;
+    int prevLen = 0;
+    for (int ch : symbols) {
+        int shift = lengths[ch] - prevLen;
+        code = shift >= 64 ? 0 : code << shift;   // 只有第一个码字的码长可能是64,此时code为0
+        codes[ch] = HuffmanCode{code, lengths[ch]};
+        ++code;
+        prevLen = lengths[ch];
+    }
+    return codes;
+}
+
+// 字母表中的digram部分;不选digram时就是纯字节字母表
+struct Alphabet {
+    vector<uint16_t> digrams;   // 第k个digram(符号256 + k)的两个字节,前一个字节在低8位
+    vector<int16_t> lookup;     // 按两个字节查digram符号,-1表示不是digram;没有digram时为空
+
+    void setDigrams(const vector<uint16_t>& chosen) {
+        digrams = chosen;
+        lookup.assign(chosen.empty() ? 0 : 65536, -1);
+        for (size_t k = 0; k < chosen.size(); ++k) {
+            lookup[chosen[k]] = (int16_t)(256 + k);
+        }
+    }
+
+    // 符号解码后输出的字节,低位在前
+    uint16_t output(int symbol) const { return symbol < 256 ? (uint16_t)symbol : digrams[symbol - 256]; }
+    int outputLength(int symbol) const { return symbol < 256 ? 1 : 2; }
+};
+
+// 挑选digram的预扫描只看文件开头这么多字节
+const size_t DIGRAM_SAMPLE_SIZE = 4 << 20;
+
+// 统计样本中单个字节和相邻字节对的出现次数,估计每个字节对改用一个符号能省多少位:
+// 原来两个字节的码长约为-log2(p(a)) - log2(p(b)),digram符号约为-log2(p(ab)),
+// 再减去文件头里记录它所需的约3字节.返回收益为正的至多maxDigrams个字节对,收益大的在前;
+// 相互重叠的字节对会抢同一批字节,这只是粗略的排序,具体取前几个由sampleDigrams试出来
+inline vector<uint16_t> rankDigrams(const char* sample, size_t size, int maxDigrams) {
+    vector<uint16_t> chosen;
+    if (size < 2 || maxDigrams <= 0) return chosen;
+    vector<uint32_t> counts(65536, 0);
+    array<uint32_t, 256> bytes;
+    bytes.fill(0);
+    for (size_t i = 0; i + 1 < size; ++i) {
+        counts[(unsigned char)sample[i] | (unsigned char)sample[i + 1] << 8]++;
+        bytes[(unsigned char)sample[i]]++;
+    }
+    bytes[(unsigned char)sample[size - 1]]++;
+
+    vector<pair<double, uint16_t>> gains;
+    double total = (double)size;
+    for (uint32_t pair = 0; pair < 65536; ++pair) {
+        if (counts[pair] < 2) continue;
+        double count = counts[pair];
+        double separate = -log2(bytes[pair & 0xFF] / total) - log2(bytes[pair >> 8] / total);
+        double gain = count * (separate + log2(count / total)) - 24;
+        if (gain > 0) gains.push_back({gain, (uint16_t)pair});
+    }
+    sort(gains.begin(), gains.end(), [](const pair<double, uint16_t>& a, const pair<double, uint16_t>& b) {
+        return a.first > b.first;
+    });
+    for (size_t k = 0; k < gains.size() && k < (size_t)maxDigrams; ++k) {
+        chosen.push_back(gains[k].second);
+    }
+    return chosen;
+}
+
+// 把原文贪心地切分成符号:当前位置和下一个字节构成已选的digram就输出digram符号,否则输出单个字节.
+// 每块单独切分,编码和统计频率用同一个切分,所以块内出现的每个符号都有编码
+template <class F>
+void parseSymbols(const char* text, size_t size, const Alphabet& alphabet, F emit) {
+    const unsigned char* data = (const unsigned char*)text;
+    if (alphabet.lookup.empty()) {
+        for (size_t i = 0; i < size; ++i) emit(data[i]);
+        return;
+    }
+    const int16_t* lookup = alphabet.lookup.data();
+    size_t i = 0;
+    while (i + 1 < size) {
+        int symbol = lookup[data[i] | data[i + 1] << 8];
+        if (symbol >= 0) {
+            emit(symbol);
+            i += 2;
+        } else {
+            emit(data[i]);
+            ++i;
+        }
+    }
+    if (i < size) emit(data[i]);
+}
+
+// 按parseSymbols的切分统计符号,累加到freq中;与countBytes一样拆成8组16位计数器,
+// 第j个符号计到第j % 8组,连续相同的符号也不会反复读改写同一个计数器;
+// 8组512个符号共8KB,仍在L1缓存内.每组每满65535次之前就累加到freq并清零
+inline void countSymbols(const char* text, size_t size, const Alphabet& alphabet, FrequencyTable& freq) {
+    if (alphabet.lookup.empty()) {
+        countBytes(text, size, freq);
+        return;
+    }
+    uint16_t counts[HISTOGRAM_LANES][MAX_SYMBOLS];
+    memset(counts, 0, sizeof(counts));
+    size_t n = 0;
+    auto spill = [&] {
+        for (int symbol = 0; symbol < MAX_SYMBOLS; ++symbol) {
+            uint64_t sum = 0;
+            for (int lane = 0; lane < HISTOGRAM_LANES; ++lane) sum += counts[lane][symbol];
+            freq[symbol] += sum;
+        }
+        memset(counts, 0, sizeof(counts));
+        n = 0;
+    };
+    parseSymbols(text, size, alphabet, [&](int symbol) {
+        counts[n % HISTOGRAM_LANES][symbol]++;
+        if (++n == HISTOGRAM_SPILL) spill();
+    });
+    spill();
+}
+
+// Huffman.txt中符号的写法:可打印字符原样输出,反斜杠和其余字节转义,digram写成两个字节连在一起
+inline string symbolName(int symbol, const Alphabet& alphabet) {
+    string name;
+    uint16_t bytes = alphabet.output(symbol);
+    for (int k = 0; k < alphabet.outputLength(symbol); ++k) {
+        unsigned char ch = (unsigned char)(bytes >> (8 * k));
+        if (ch == '\\') {
+            name += "\\\\";
+        } else if (ch == '\n') {
+            name += "\\n";
+        } else if (ch == '\r') {
+            name += "\\r";
+        } else if (ch == '\t') {
+            name += "\\t";
+        } else if (ch >= 32 && ch < 127) {
+            name += (char)ch;
+        } else {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "\\x%02X", ch);
+            name += hex;
+        }
+    }
+    return name;
+}
+
+// 将Huffman编码表写入文件
+inline void writeHuffmanCodes(const CodeTable& codes, const Alphabet& alphabet, const string& filename) {
+    ofstream file(filename, ios::binary);
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (codes[ch].len == 0) continue;
+        string code;
+        for (int i = codes[ch].len - 1; i >= 0; --i) {
+            code += ((codes[ch].bits >> i) & 1) ? '1' : '0';
+        }
+        file << symbolName(ch, alphabet) << ": " << code << "\n";
+    }
+    file.close();
+}
+
+// 64位累加器:新码字从高位往低位依次拼接,攒满64位就整字写入输出缓冲
+struct BitWriter {
+    string out;
+    size_t pos = 0;
+    uint64_t buffer = 0;
+    int count = 0;
+
+    void writeWord(uint64_t word) {
+        if (pos + 8 > out.size()) out.resize(max<size_t>(out.size() * 2, 64));
+        for (int i = 0; i < 8; ++i) {
+            out[pos + i] = (char)(word >> (56 - 8 * i));
+        }
+        pos += 8;
+    }
+
+    void put(uint64_t bits, int len) {
+        if (count + len < 64) {
+            buffer |= bits << (64 - count - len);
+            count += len;
+            return;
+        }
+        // 先填满当前字,剩下的位放到新字的高位
+        int rest = count + len - 64;
+        writeWord(buffer | (bits >> rest));
+        buffer = rest ? bits << (64 - rest) : 0;
+        count = rest;
+    }
+
+    // 写出剩余不足一个字的位,末尾补0到整字节,返回全部字节
+    string finish() {
+        int bytes = (count + 7) / 8;
+        if (pos + 8 > out.size()) out.resize(pos + 8);
+        for (int i = 0; i < bytes; ++i) {
+            out[pos + i] = (char)(buffer >> (56 - 8 * i));
+        }
+        out.resize(pos + bytes);
+        return out;
+    }
+};
+
+// 将一段文本编码为紧凑的二进制数据(高位在前,末尾补0)
+inline string encodeText(const char* text, size_t size, const CodeTable& codes, const Alphabet& alphabet) {
+    BitWriter writer;
+    writer.out.resize(size / 2 + 64);
+    parseSymbols(text, size, alphabet, [&](int symbol) {
+        const HuffmanCode& code = codes[symbol];
+        writer.put(code.bits, code.len);
+    });
+    return writer.finish();
+}
+
+// code.dat的格式(整数均为小端):
+//   文件头: 4字节魔数"HUF4" | 8字节原文长度 | 4字节分块大小 | 2字节digram个数D
+//           | 64字节位图(有编码的符号) | D个digram各2字节 | 每个有编码的符号1字节码长
+//   块索引: 每块12字节,依次为本块原文长度 | 本块编码字节数 | 本块原文CRC32
+//   之后依次存放各块的编码数据(末尾补0到整字节)
+// 所有块共用文件头里的编码表且各自按字节对齐,由块索引可以直接算出每块的位置,
+// 因此编码和解码都可以把若干块分给多个线程同时处理
+const char HEADER_MAGIC[4] = {'H', 'U', 'F', '4'};
+const size_t HEADER_BITMAP_OFFSET = 18;
+const size_t HEADER_FIXED_SIZE = HEADER_BITMAP_OFFSET + MAX_SYMBOLS / 8;
+const size_t BLOCK_INDEX_ENTRY = 12;
+const uint32_t BLOCK_SIZE = 1 << 20;      // 每块原文字节数
+const uint64_t MAX_BLOCK_COUNT = 1 << 26;
+
+struct BlockInfo {
+    uint32_t rawSize;       // 本块原文字节数
+    uint32_t encodedSize;   // 本块编码字节数
+    uint32_t checksum;      // 本块原文CRC32
+};
+
+struct HuffmanHeader {
+    uint64_t length;            // 原文字节数
+    uint32_t blockSize;         // 分块大小
+    vector<uint16_t> digrams;   // 字母表中的digram
+    CodeLengths lengths;        // 每个符号的码长
+    vector<BlockInfo> blocks;   // 块索引
+};
+
+inline uint64_t blockCount(uint64_t length, uint32_t blockSize) {
+    return (length + blockSize - 1) / blockSize;
+}
+
+// 标准CRC-32(多项式0xEDB88320),可以分段累计:crc32Update(crc32Update(0, a), b) == crc32(a + b)
+inline uint32_t crc32Update(uint32_t crc, const char* data, size_t size) {
+    static const array<uint32_t, 256> table = [] {
+        array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline uint32_t crc32(const string& data) {
+    return crc32Update(0, data.data(), data.size());
+}
+
+inline void putLE(string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out += (char)(value >> (8 * i));
+    }
+}
+
+inline uint64_t getLE(const string& in, size_t pos, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= (uint64_t)(unsigned char)in[pos + i] << (8 * i);
+    }
+    return value;
+}
+
+inline string serializeHeader(const HuffmanHeader& header) {
+    string out(HEADER_MAGIC, 4);
+    putLE(out, header.length, 8);
+    putLE(out, header.blockSize, 4);
+    putLE(out, header.digrams.size(), 2);
+    string bitmap(MAX_SYMBOLS / 8, '\0');
+    string lens;
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (header.lengths[ch] > 0) {
+            bitmap[ch >> 3] |= (char)(1 << (ch & 7));
+            lens += (char)header.lengths[ch];
+        }
+    }
+    out += bitmap;
+    for (uint16_t digram : header.digrams) {
+        putLE(out, digram, 2);
+    }
+    out += lens;
+    for (const BlockInfo& block : header.blocks) {
+        putLE(out, block.rawSize, 4);
+        putLE(out, block.encodedSize, 4);
+        putLE(out, block.checksum, 4);
+    }
+    return out;
+}
+
+// 码长是否构成完整的前缀码(Kraft和恰好为1),否则解码表会留下没有码字的空位.
+// 从最长的码长往上逐层两两合并,每层都要凑成对,最后恰好剩下根;
+// 只有一种字符时按约定用1位的"0",是唯一允许的例外
+inline bool completeCode(const array<int, 65>& lengthCount, int symbolCount) {
+    if (symbolCount == 0) return true;
+    if (symbolCount == 1) return lengthCount[1] == 1;
+    uint64_t nodes = 0;
+    for (int len = 64; len >= 1; --len) {
+        nodes += lengthCount[len];
+        if (nodes % 2) return false;
+        nodes /= 2;
+    }
+    return nodes == 1;
+}
+
+// 解析文件头和块索引,成功时offset指向第一块编码数据的起始位置
+inline bool parseHeader(const string& bytes, HuffmanHeader& header, size_t& offset) {
+    if (bytes.size() < HEADER_FIXED_SIZE || bytes.compare(0, 4, HEADER_MAGIC, 4) != 0) return false;
+    header.length = getLE(bytes, 4, 8);
+    header.blockSize = (uint32_t)getLE(bytes, 12, 4);
+    size_t digramCount = getLE(bytes, 16, 2);
+    if (header.blockSize == 0 || digramCount > MAX_DIGRAMS) return false;
+    offset = HEADER_FIXED_SIZE;
+    if (bytes.size() < offset + 2 * digramCount) return false;
+    header.digrams.resize(digramCount);
+    for (uint16_t& digram : header.digrams) {
+        digram = (uint16_t)getLE(bytes, offset, 2);
+        offset += 2;
+    }
+    header.lengths.fill(0);
+    array<int, 65> lengthCount{};
+    int symbolCount = 0;
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (bytes[HEADER_BITMAP_OFFSET + (ch >> 3)] & (1 << (ch & 7))) {
+            if (ch >= 256 + (int)digramCount || offset >= bytes.size()) return false;
+            header.lengths[ch] = (uint8_t)bytes[offset++];
+            if (header.lengths[ch] == 0 || header.lengths[ch] > 64) return false;
+            lengthCount[header.lengths[ch]]++;
+            ++symbolCount;
+        }
+    }
+    if (!completeCode(lengthCount, symbolCount)) return false;
+
+    uint64_t count = blockCount(header.length, header.blockSize);
+    if (count > MAX_BLOCK_COUNT || bytes.size() < offset + count * BLOCK_INDEX_ENTRY) return false;
+    header.blocks.resize(count);
+    uint64_t remaining = header.length;
+    for (BlockInfo& block : header.blocks) {
+        block.rawSize = (uint32_t)getLE(bytes, offset, 4);
+        block.encodedSize = (uint32_t)getLE(bytes, offset + 4, 4);
+        block.checksum = (uint32_t)getLE(bytes, offset + 8, 4);
+        offset += BLOCK_INDEX_ENTRY;
+        // 除最后一块外每块都是满的
+        if (block.rawSize != min<uint64_t>(remaining, header.blockSize)) return false;
+        remaining -= block.rawSize;
+    }
+    return true;
+}
+
+// 查表解码:一级表用码流最前面的ROOT_BITS位直接索引,码长不超过ROOT_BITS的字符一次查表即可得到;
+// 更长的码在一级表里存一个指向二级表的链接,二级表再用接下来的若干位索引,必要时继续往下
+const int ROOT_BITS = 11;
+const int SUB_BITS = 8;    // 每级子表最多用多少位索引
+
+struct DecodeEntry {
+    int32_t value;   // 叶子:要输出的字节,低位在前;链接:子表起始下标
+    uint8_t bits;    // 叶子:本级消耗的位数;链接:子表的索引位数
+    uint8_t emit;    // 叶子:输出的字节数(1或2)
+    bool link;
+};
+
+struct DecodeTable {
+    vector<DecodeEntry> entries;   // 所有表连续存放,一级表在最前面
+};
+
+// 建解码表时使用的码字
+struct CodeWord {
+    uint16_t output;   // 解码后输出的字节
+    uint8_t emit;      // 输出的字节数
+    uint64_t code;
+    int len;
+};
+
+// 为去掉前consumed位后的码字集合建一张tableBits位的表,返回表的起始下标
+inline int32_t buildDecodeLevel(DecodeTable& table, const vector<CodeWord>& codes, int consumed, int tableBits) {
+    int32_t base = (int32_t)table.entries.size();
+    table.entries.resize(base + (size_t(1) << tableBits), DecodeEntry{0, 0, 0, false});
+
+    // 按本级索引分组,较长的码交给子表
+    vector<vector<CodeWord>> longer(size_t(1) << tableBits);
+    for (const CodeWord& cw : codes) {
+        int rest = cw.len - consumed;
+        uint64_t restCode = cw.code & ((rest >= 64) ? ~0ULL : ((1ULL << rest) - 1));
+        if (rest <= tableBits) {
+            uint64_t first = restCode << (tableBits - rest);
+            uint64_t span = 1ULL << (tableBits - rest);
+            for (uint64_t i = 0; i < span; ++i) {
+                table.entries[base + first + i] = DecodeEntry{cw.output, (uint8_t)rest, cw.emit, false};
+            }
+        } else {
+            longer[restCode >> (rest - tableBits)].push_back(cw);
+        }
+    }
+    for (size_t i = 0; i < longer.size(); ++i) {
+        if (longer[i].empty()) continue;
+        int maxRest = 0;
+        for (const CodeWord& cw : longer[i]) {
+            maxRest = max(maxRest, cw.len - consumed - tableBits);
+        }
+        int subBits = min(maxRest, SUB_BITS);
+        int32_t sub = buildDecodeLevel(table, longer[i], consumed + tableBits, subBits);
+        table.entries[base + i] = DecodeEntry{sub, (uint8_t)subBits, 0, true};
+    }
+    return base;
+}
+
+// 由Huffman编码表建立解码表,叶子里直接存放符号对应的字节
+inline DecodeTable buildDecodeTable(const CodeTable& codeTable, const Alphabet& alphabet) {
+    vector<CodeWord> codes;
+    for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+        if (codeTable[ch].len > 0) {
+            codes.push_back(CodeWord{alphabet.output(ch), (uint8_t)alphabet.outputLength(ch),
+                                     codeTable[ch].bits, codeTable[ch].len});
+        }
+    }
+    DecodeTable table;
+    buildDecodeLevel(table, codes, 0, ROOT_BITS);
+    return table;
+}
+
+// 64位位缓冲:未消耗的位靠高位存放,每次补充整字节,保证查表前至少有56位可用
+struct BitReader {
+    const unsigned char* data;
+    size_t size;
+    size_t pos = 0;
+    uint64_t buffer = 0;
+    int count = 0;
+
+    BitReader(const string& bytes) : data((const unsigned char*)bytes.data()), size(bytes.size()) {}
+
+    void refill() {
+        if (pos + 8 <= size) {
+            uint64_t word = 0;
+            for (int i = 0; i < 8; ++i) {
+                word = (word << 8) | data[pos + i];
+            }
+            buffer |= word >> count;
+            pos += (63 - count) >> 3;
+            count |= 56;
+        } else {
+            while (count <= 56) {
+                uint64_t byte = pos < size ? data[pos] : 0;   // 末尾之后按0处理
+                ++pos;
+                buffer |= byte << (56 - count);
+                count += 8;
+            }
+        }
+    }
+
+    uint32_t peek(int bits) const {
+        return bits == 0 ? 0 : (uint32_t)(buffer >> (64 - bits));
+    }
+
+    void consume(int bits) {
+        buffer <<= bits;
+        count -= bits;
+    }
+};
+
+// 解码函数:每次查表直接得到一个完整符号,digram符号一次输出两个字节;
+// outputSize为原文字节数,忽略末尾的填充位.每个符号都先写两个字节再按实际字节数前进,
+// 所以输出缓冲多留1字节.补充一次缓冲后至少有56位,足够连续解出5个只用一级表的符号.
+// 查到没有码字的空位(只可能出现在只有一种字符的码表里)说明数据已损坏,返回false
+inline bool decodeText(const string& bytes, const DecodeTable& table, size_t outputSize, string& decodedText) {
+    decodedText.assign(outputSize + 1, '\0');
+    char* out = &decodedText[0];
+    BitReader reader(bytes);
+    const DecodeEntry* entries = table.entries.data();
+    size_t i = 0;
+    while (i < outputSize) {
+        reader.refill();
+        for (int k = 0; k < 56 / ROOT_BITS && i < outputSize; ++k) {
+            DecodeEntry entry = entries[reader.peek(ROOT_BITS)];
+            if (entry.link) {
+                // 长码:逐级查子表,每级之前保证缓冲够用
+                reader.consume(ROOT_BITS);
+                do {
+                    if (reader.count < 32) reader.refill();
+                    int bits = entry.bits;
+                    entry = entries[entry.value + reader.peek(bits)];
+                    if (entry.link) reader.consume(bits);
+                } while (entry.link);
+                if (entry.bits == 0) return false;
+                reader.consume(entry.bits);
+                out[i] = (char)entry.value;
+                out[i + 1] = (char)(entry.value >> 8);
+                i += entry.emit;
+                break;
+            }
+            if (entry.bits == 0) return false;
+            reader.consume(entry.bits);
+            out[i] = (char)entry.value;
+            out[i + 1] = (char)(entry.value >> 8);
+            i += entry.emit;
+        }
+    }
+    decodedText.resize(outputSize);
+    return true;
+}
+
+const unsigned BLOCKS_PER_THREAD = 2;   // 每批读入的块数为线程数的若干倍,减少线程间互相等待
+
+// 用threads个线程处理下标[0, count),每个线程不断领取下一个未处理的下标;f(i, t)中t为线程编号
+template <class F>
+void parallelFor(size_t count, unsigned threads, F f) {
+    if (threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) f(i, 0u);
+        return;
+    }
+    atomic<size_t> next(0);
+    vector<thread> workers;
+    for (unsigned t = 0; t < min<size_t>(threads, count); ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i; (i = next++) < count; ) f(i, t);
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// 从文件连续读入至多buffers.size()块,每块至多blockSize字节;返回读到的块数
+inline size_t readBatch(FILE* file, vector<vector<char>>& buffers, vector<size_t>& sizes, uint32_t blockSize) {
+    size_t got = 0;
+    for (; got < buffers.size(); ++got) {
+        buffers[got].resize(blockSize);
+        sizes[got] = fread(buffers[got].data(), 1, blockSize, file);
+        if (sizes[got] == 0) break;
+    }
+    return got;
+}
+
+// 预扫描:读入文件开头的一段样本,分别试用排好序的前0, 16, 32, 64...个digram,
+// 在样本上实际切分、建树,算出编码后的总位数(含文件头),取最小的那一组;
+// 随机的二进制数据里没有划算的字节对,自然退化成纯字节字母表
+inline bool sampleDigrams(const string& filename, int maxDigrams, int maxLength, Alphabet& alphabet) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    vector<char> sample(DIGRAM_SAMPLE_SIZE);
+    size_t size = fread(sample.data(), 1, sample.size(), file);
+    fclose(file);
+
+    vector<uint16_t> candidates = rankDigrams(sample.data(), size, maxDigrams);
+    vector<uint16_t> best;
+    uint64_t bestBits = UINT64_MAX;
+    for (size_t k = 0; ; k = min(candidates.size(), k == 0 ? (size_t)16 : 2 * k)) {
+        Alphabet trial;
+        trial.setDigrams(vector<uint16_t>(candidates.begin(), candidates.begin() + k));
+        FrequencyTable freq;
+        freq.fill(0);
+        parseSymbols(sample.data(), size, trial, [&](int symbol) { freq[symbol]++; });
+        CodeLengths lengths = codeLengths(generate(build(freq)));
+        limitCodeLengths(lengths, freq, maxLength);
+        uint64_t bits = 16 * k;
+        for (int ch = 0; ch < MAX_SYMBOLS; ++ch) {
+            if (lengths[ch] > 0) bits += freq[ch] * lengths[ch] + 8;
+        }
+        if (bits < bestBits) {
+            bestBits = bits;
+            best = trial.digrams;
+        }
+        if (k == candidates.size()) break;
+    }
+    alphabet.setDigrams(best);
+    return true;
+}
+
+// 第一遍扫描:按批读入若干块,每个线程统计到自己的频率表里,最后合并;内存占用与文件大小无关.
+// 纯字节字母表直接统计字节,否则按编码时的切分统计符号,两者都用分组计数器
+inline bool calculate(const string& filename, const Alphabet& alphabet, FrequencyTable& freq, uint64_t& length,
+               unsigned threads) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    vector<FrequencyTable> local(threads);
+    for (FrequencyTable& table : local) table.fill(0);
+    vector<vector<char>> buffers(threads * BLOCKS_PER_THREAD);
+    vector<size_t> sizes(buffers.size());
+    length = 0;
+    size_t got;
+    while ((got = readBatch(file, buffers, sizes, BLOCK_SIZE)) > 0) {
+        parallelFor(got, threads, [&](size_t i, unsigned t) {
+            countSymbols(buffers[i].data(), sizes[i], alphabet, local[t]);
+        });
+        for (size_t i = 0; i < got; ++i) length += sizes[i];
+    }
+    fclose(file);
+
+    freq.fill(0);
+    for (const FrequencyTable& table : local) {
+        for (int ch = 0; ch < MAX_SYMBOLS; ++ch) freq[ch] += table[ch];
+    }
+    return true;
+}
+
+// 读入完整的文件头和块索引
+inline bool readHeader(FILE* file, HuffmanHeader& header) {
+    string bytes(HEADER_FIXED_SIZE, '\0');
+    if (fread(&bytes[0], 1, HEADER_FIXED_SIZE, file) != HEADER_FIXED_SIZE) return false;
+    uint64_t length = getLE(bytes, 4, 8);
+    uint32_t blockSize = (uint32_t)getLE(bytes, 12, 4);
+    if (blockSize == 0 || blockCount(length, blockSize) > MAX_BLOCK_COUNT) return false;
+    size_t rest = blockCount(length, blockSize) * BLOCK_INDEX_ENTRY + 2 * getLE(bytes, 16, 2);
+    for (size_t i = HEADER_BITMAP_OFFSET; i < HEADER_FIXED_SIZE; ++i) {
+        rest += __builtin_popcount((unsigned char)bytes[i]);
+    }
+    bytes.resize(HEADER_FIXED_SIZE + rest);
+    if (fread(&bytes[HEADER_FIXED_SIZE], 1, rest, file) != rest) return false;
+    size_t offset;
+    return parseHeader(bytes, header, offset);
+}
+
+// 第二遍:按批读入原文,各块由多个线程同时编码,再按顺序写出;
+// 块索引要等所有块编码完才知道,先占位,最后回到文件开头重写文件头
+inline bool compressFile(const string& input, const string& output, HuffmanHeader& header, const CodeTable& codes,
+                  const Alphabet& alphabet, unsigned threads) {
+    FILE* in = fopen(input.c_str(), "rb");
+    if (!in) return false;
+    FILE* out = fopen(output.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+    header.blocks.assign(blockCount(header.length, header.blockSize), BlockInfo{0, 0, 0});
+    string head = serializeHeader(header);
+    fwrite(head.data(), 1, head.size(), out);
+
+    vector<vector<char>> buffers(threads * BLOCKS_PER_THREAD);
+    vector<size_t> sizes(buffers.size());
+    vector<string> encoded(buffers.size());
+    size_t done = 0;
+    bool ok = true;
+    size_t got;
+    while (ok && (got = readBatch(in, buffers, sizes, header.blockSize)) > 0) {
+        if (done + got > header.blocks.size()) {
+            ok = false;   // 两遍之间文件变长了
+            break;
+        }
+        parallelFor(got, threads, [&](size_t i, unsigned) {
+            encoded[i] = encodeText(buffers[i].data(), sizes[i], codes, alphabet);
+            header.blocks[done + i] = BlockInfo{(uint32_t)sizes[i], (uint32_t)encoded[i].size(),
+                                                crc32Update(0, buffers[i].data(), sizes[i])};
+        });
+        for (size_t i = 0; i < got; ++i) {
+            fwrite(encoded[i].data(), 1, encoded[i].size(), out);
+        }
+        done += got;
+    }
+    fclose(in);
+    if (done != header.blocks.size()) ok = false;
+    if (ok) {
+        head = serializeHeader(header);
+        ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(head.data(), 1, head.size(), out) == head.size();
+    }
+    ok = ok && !ferror(out);
+    fclose(out);
+    return ok;
+}
+
+// 按批读入编码数据,各块由多个线程同时解码并核对CRC32,再按顺序写出原文
+inline bool decompressFile(const string& input, const string& output, unsigned threads) {
+    FILE* in = fopen(input.c_str(), "rb");
+    if (!in) return false;
+    HuffmanHeader header;
+    if (!readHeader(in, header)) {
+        cerr << input << " 文件头损坏" << endl;
+        fclose(in);
+        return false;
+    }
+    FILE* out = fopen(output.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+    Alphabet alphabet;
+    alphabet.setDigrams(header.digrams);
+    DecodeTable decodeTable = buildDecodeTable(canonicalCodes(header.lengths), alphabet);
+
+    size_t batch = threads * BLOCKS_PER_THREAD;
+    vector<string> encoded(batch), decoded(batch);
+    vector<char> failed(batch);
+    bool ok = true;
+    for (size_t first = 0; ok && first < header.blocks.size(); first += batch) {
+        size_t got = min(batch, header.blocks.size() - first);
+        for (size_t i = 0; i < got; ++i) {
+            encoded[i].resize(header.blocks[first + i].encodedSize);
+            if (fread(&encoded[i][0], 1, encoded[i].size(), in) != encoded[i].size()) ok = false;
+        }
+        if (!ok) break;
+        parallelFor(got, threads, [&](size_t i, unsigned) {
+            const BlockInfo& block = header.blocks[first + i];
+            failed[i] = !decodeText(encoded[i], decodeTable, block.rawSize, decoded[i]) ||
+                        crc32(decoded[i]) != block.checksum;
+        });
+        for (size_t i = 0; i < got; ++i) {
+            if (failed[i]) {
+                cerr << "第" << first + i << "块校验失败" << endl;
+                ok = false;
+                break;
+            }
+            fwrite(decoded[i].data(), 1, decoded[i].size(), out);
+        }
+    }
+    fclose(in);
+    fclose(out);
+    if (!ok) {
+        cerr << "解码结果校验失败" << endl;
+        return false;
+    }
+    return true;
+}
+
+#endif
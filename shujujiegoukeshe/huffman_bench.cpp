@@ -0,0 +1,369 @@
+// 5.cpp的Huffman编解码性能测试:最初基于字符串的实现与现在各模式的对比
+// 用法: huffman_bench [生成文件的MB数] [其他文件...]
+// 语料包括若干生成的文件、source.txt以及命令行给出的文件;每个(文件, 模式)在单独的子进程里运行,
+// 报告压缩率、编码/解码速度、建表用时和峰值内存,并逐字节核对解码结果.
+// 最后核对5.cpp生成的recode.txt是否与source.txt完全一致;任何一项失败都以非0退出.
+#include <iostream>
+#include <vector>
+#include <string>
+#include <queue>
+#include <unordered_map>
+#include <bitset>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#include "huffman.h"
+#include "bench_util.h"
+using namespace std;
+
+// 最初的实现:unordered_map统计频率,new出来的树,'0'/'1'字符串编码,逐位走树解码.
+// 只保留内存中的编解码部分;为了能正确往返,最后不足8位的一段补0左对齐,解码时按原文长度截断
+struct LegacyNode {
+    char ch;
+    int frequency;
+    LegacyNode* left;
+    LegacyNode* right;
+
+    LegacyNode(char character, int freq) : ch(character), frequency(freq), left(nullptr), right(nullptr) {}
+
+    struct Compare {
+        bool operator()(LegacyNode* left, LegacyNode* right) {
+            return left->frequency > right->frequency;
+        }
+    };
+};
+
+void legacyGenerate(LegacyNode* root, const string& code, unordered_map<char, string>& huffmanCodes) {
+    if (root == nullptr) {
+        return;
+    }
+    if (root->left == nullptr && root->right == nullptr) {
+        huffmanCodes[root->ch] = code.empty() ? "0" : code;
+    }
+    legacyGenerate(root->left, code + "0", huffmanCodes);
+    legacyGenerate(root->right, code + "1", huffmanCodes);
+}
+
+LegacyNode* legacyBuild(const unordered_map<char, int>& freqMap) {
+    priority_queue<LegacyNode*, vector<LegacyNode*>, LegacyNode::Compare> minHeap;
+    for (const auto& entry : freqMap) {
+        minHeap.push(new LegacyNode(entry.first, entry.second));
+    }
+    while (minHeap.size() > 1) {
+        LegacyNode* left = minHeap.top();
+        minHeap.pop();
+        LegacyNode* right = minHeap.top();
+        minHeap.pop();
+        LegacyNode* newNode = new LegacyNode('\0', left->frequency + right->frequency);
+        newNode->left = left;
+        newNode->right = right;
+        minHeap.push(newNode);
+    }
+    return minHeap.top();
+}
+
+void legacyDestroy(LegacyNode* root) {
+    if (root == nullptr) return;
+    legacyDestroy(root->left);
+    legacyDestroy(root->right);
+    delete root;
+}
+
+string legacyPack(const string& binaryData) {
+    string bytes;
+    for (size_t i = 0; i < binaryData.size(); i += 8) {
+        string chunk = binaryData.substr(i, 8);
+        chunk.resize(8, '0');
+        bytes += (char)bitset<8>(chunk).to_ulong();
+    }
+    return bytes;
+}
+
+string legacyDecode(const string& bytes, LegacyNode* root, size_t length) {
+    string binaryData;
+    for (char byte : bytes) {
+        binaryData += bitset<8>((unsigned char)byte).to_string();
+    }
+    string decodedText;
+    LegacyNode* currentNode = root;
+    for (char bit : binaryData) {
+        if (decodedText.size() == length) break;
+        if (root->left != nullptr) {
+            currentNode = bit == '0' ? currentNode->left : currentNode->right;
+        }
+        if (currentNode->left == nullptr && currentNode->right == nullptr) {
+            decodedText += currentNode->ch;
+            currentNode = root;
+        }
+    }
+    return decodedText;
+}
+
+// 一次运行的结果
+struct BenchResult {
+    uint64_t inputBytes;
+    uint64_t outputBytes;
+    double encodeSeconds;
+    double tableSeconds;
+    double decodeSeconds;
+    double peakMB;
+    bool roundTrip;
+};
+
+struct Mode {
+    const char* name;
+    bool legacy;
+    unsigned threads;
+    int maxDigrams;
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+string readWhole(const string& filename) {
+    string data;
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) return data;
+    char buffer[1 << 16];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, n);
+    }
+    fclose(file);
+    return data;
+}
+
+bool sameFile(const string& a, const string& b) {
+    FILE* fa = fopen(a.c_str(), "rb");
+    FILE* fb = fopen(b.c_str(), "rb");
+    bool same = fa && fb;
+    vector<char> ba(1 << 20), bb(1 << 20);
+    while (same) {
+        size_t na = fread(ba.data(), 1, ba.size(), fa);
+        size_t nb = fread(bb.data(), 1, bb.size(), fb);
+        if (na != nb || memcmp(ba.data(), bb.data(), na) != 0) same = false;
+        if (na == 0) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+BenchResult runLegacy(const string& input) {
+    BenchResult result{};
+    string text = readWhole(input);
+    result.inputBytes = text.size();
+
+    auto start = chrono::steady_clock::now();
+    unordered_map<char, int> freqMap;
+    for (char ch : text) freqMap[ch]++;
+    double countSeconds = secondsSince(start);
+
+    auto tableStart = chrono::steady_clock::now();
+    LegacyNode* root = freqMap.empty() ? nullptr : legacyBuild(freqMap);
+    unordered_map<char, string> huffmanCodes;
+    legacyGenerate(root, "", huffmanCodes);
+    result.tableSeconds = secondsSince(tableStart);
+
+    auto encodeStart = chrono::steady_clock::now();
+    string encodedText;
+    for (char ch : text) encodedText += huffmanCodes.at(ch);
+    string bytes = legacyPack(encodedText);
+    result.encodeSeconds = countSeconds + secondsSince(encodeStart);
+    result.outputBytes = bytes.size();
+
+    auto decodeStart = chrono::steady_clock::now();
+    string decoded = root ? legacyDecode(bytes, root, text.size()) : string();
+    result.decodeSeconds = secondsSince(decodeStart);
+    result.roundTrip = decoded == text;
+    legacyDestroy(root);
+    return result;
+}
+
+// 与5.cpp的main相同的流程,只是分别计时,并把中间文件放在临时目录
+BenchResult runCodec(const string& input, const Mode& mode, const string& tempDir) {
+    BenchResult result{};
+    string encodedFile = tempDir + "/bench_code.dat";
+    string decodedFile = tempDir + "/bench_recode.txt";
+
+    auto start = chrono::steady_clock::now();
+    Alphabet alphabet;
+    FrequencyTable freq;
+    uint64_t length = 0;
+    if (!sampleDigrams(input, mode.maxDigrams, DEFAULT_MAX_CODE_LENGTH, alphabet) ||
+        !calculate(input, alphabet, freq, length, mode.threads)) {
+        return result;
+    }
+    double scanSeconds = secondsSince(start);
+
+    auto tableStart = chrono::steady_clock::now();
+    CodeLengths lengths = codeLengths(generate(build(freq)));
+    limitCodeLengths(lengths, freq, DEFAULT_MAX_CODE_LENGTH);
+    CodeTable codes = canonicalCodes(lengths);
+    DecodeTable decodeTable = buildDecodeTable(codes, alphabet);
+    result.tableSeconds = secondsSince(tableStart);
+
+    auto encodeStart = chrono::steady_clock::now();
+    HuffmanHeader header{length, BLOCK_SIZE, alphabet.digrams, lengths, {}};
+    bool ok = compressFile(input, encodedFile, header, codes, alphabet, mode.threads);
+    result.encodeSeconds = scanSeconds + secondsSince(encodeStart);
+
+    auto decodeStart = chrono::steady_clock::now();
+    ok = ok && decompressFile(encodedFile, decodedFile, mode.threads);
+    result.decodeSeconds = secondsSince(decodeStart);
+
+    result.inputBytes = length;
+    FILE* file = fopen(encodedFile.c_str(), "rb");
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        result.outputBytes = (uint64_t)ftell(file);
+        fclose(file);
+    }
+    result.roundTrip = ok && sameFile(input, decodedFile);
+    remove(encodedFile.c_str());
+    remove(decodedFile.c_str());
+    return result;
+}
+
+BenchResult runMode(const string& input, const Mode& mode, const string& tempDir) {
+    BenchResult result = mode.legacy ? runLegacy(input) : runCodec(input, mode, tempDir);
+    result.peakMB = peakRSS() / 1048576.0;
+    return result;
+}
+
+// 运行并打印一行结果;运行失败或解码结果与原文不一致时返回false
+bool report(const string& label, const string& input, const Mode& mode, const string& tempDir) {
+    BenchResult r;
+    if (!runIsolated(r, [&] { return runMode(input, mode, tempDir); })) {
+        printf("%-14s %-16s  failed\n", label.c_str(), mode.name);
+        return false;
+    }
+    double mb = r.inputBytes / 1e6;
+    printf("%-14s %-16s %10.2f %8.3f %9.1f %9.1f %10.1f %8.1f  %s\n",
+           label.c_str(), mode.name, mb, r.inputBytes ? (double)r.outputBytes / r.inputBytes : 0.0,
+           r.encodeSeconds > 0 ? mb / r.encodeSeconds : 0.0, r.decodeSeconds > 0 ? mb / r.decodeSeconds : 0.0,
+           r.tableSeconds * 1e6, r.peakMB, r.roundTrip ? "ok" : "MISMATCH");
+    fflush(stdout);
+    return r.roundTrip;
+}
+
+// 生成测试文件
+void writeFile(const string& filename, const string& data) {
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file) return;
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+}
+
+string randomBytes(size_t size, mt19937& rng) {
+    string data(size, '\0');
+    for (char& ch : data) ch = (char)rng();
+    return data;
+}
+
+// 按英文字母频率随机生成单词组成的文本
+string englishText(size_t size, mt19937& rng) {
+    const string letters = "eeeeeeeeeeeetttttttttaaaaaaaaooooooooiiiiiiinnnnnnnsssssshhhhhhrrrrrrddddlllluuucccmmmwwffggyyppbbvk";
+    string data;
+    data.reserve(size + 16);
+    while (data.size() < size) {
+        int word = 1 + rng() % 9;
+        for (int i = 0; i < word; ++i) data += letters[rng() % letters.size()];
+        data += (rng() % 12 == 0) ? ".\n" : " ";
+    }
+    data.resize(size);
+    return data;
+}
+
+// 模拟服务日志,行尾为CRLF
+string logLines(size_t size, mt19937& rng) {
+    const char* levels[] = {"INFO", "WARN", "ERROR", "DEBUG"};
+    const char* components[] = {"http.server", "db.pool", "auth", "cache", "scheduler"};
+    const char* messages[] = {"request completed in %u ms", "connection from 10.0.%u.%u accepted",
+                              "user %u logged in", "cache miss for key user:%u", "query returned %u rows"};
+    string data;
+    data.reserve(size + 256);
+    char line[256];
+    char message[96];
+    while (data.size() < size) {
+        snprintf(message, sizeof(message), messages[rng() % 5], (unsigned)(rng() % 1000), (unsigned)(rng() % 256));
+        snprintf(line, sizeof(line), "2024-05-%02u 12:%02u:%02u.%03u [%s] %s - %s\r\n", (unsigned)(1 + rng() % 28),
+                 (unsigned)(rng() % 60), (unsigned)(rng() % 60), (unsigned)(rng() % 1000), levels[rng() % 4],
+                 components[rng() % 5], message);
+        data += line;
+    }
+    data.resize(size);
+    return data;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? max(atoi(argv[1]), 1) : 16;
+    size_t size = megabytes << 20;
+    unsigned cores = max(thread::hardware_concurrency(), 1u);
+    string tempDir = "/tmp";
+#ifdef __linux__
+    char tempTemplate[] = "/tmp/huffman_bench_XXXXXX";
+    if (mkdtemp(tempTemplate)) tempDir = tempTemplate;
+#endif
+
+    mt19937 rng(12345);
+    vector<pair<string, string>> corpus;   // (显示名, 文件路径)
+    writeFile(tempDir + "/random.bin", randomBytes(size, rng));
+    corpus.push_back({"random", tempDir + "/random.bin"});
+    writeFile(tempDir + "/english.txt", englishText(size, rng));
+    corpus.push_back({"english", tempDir + "/english.txt"});
+    writeFile(tempDir + "/log.txt", logLines(size, rng));
+    corpus.push_back({"log", tempDir + "/log.txt"});
+    writeFile(tempDir + "/zeros.bin", string(size, '\0'));
+    corpus.push_back({"zeros", tempDir + "/zeros.bin"});
+    corpus.push_back({"source.txt", "source.txt"});
+    for (int i = 2; i < argc; ++i) {
+        corpus.push_back({argv[i], argv[i]});
+    }
+
+    string threadsName = "digram x" + to_string(cores);
+    Mode modes[] = {
+        {"legacy string", true, 1, 0},
+        {"bytes x1", false, 1, 0},
+        {"digram x1", false, 1, MAX_DIGRAMS},
+        {threadsName.c_str(), false, cores, MAX_DIGRAMS},
+    };
+
+    bool ok = true;   // 任何一次运行失败或往返不一致都以非0退出
+    printf("%-14s %-16s %10s %8s %9s %9s %10s %8s  %s\n",
+           "file", "mode", "MB", "ratio", "enc MB/s", "dec MB/s", "table(us)", "peakMB", "round trip");
+    for (const auto& file : corpus) {
+        FILE* probe = fopen(file.second.c_str(), "rb");
+        if (!probe) {
+            printf("%-14s 无法打开\n", file.first.c_str());
+            ok = false;
+            continue;
+        }
+        fclose(probe);
+        for (const Mode& mode : modes) {
+            ok = report(file.first, file.second, mode, tempDir) && ok;
+        }
+    }
+
+    // 5.cpp自己的输出:recode.txt应与source.txt逐字节相同
+    if (sameFile("source.txt", "recode.txt")) {
+        printf("source.txt == recode.txt\n");
+    } else {
+        printf("source.txt != recode.txt (先运行5生成recode.txt)\n");
+        ok = false;
+    }
+
+    for (const char* name : {"/random.bin", "/english.txt", "/log.txt", "/zeros.bin"}) {
+        remove((tempDir + name).c_str());
+    }
+#ifdef __linux__
+    if (tempDir != "/tmp") rmdir(tempDir.c_str());
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+#ifndef PRIME_SIEVE_H
+#define PRIME_SIEVE_H
+
+// 4.cpp(AVL树)和8.cpp(B树)共用的质数生成
+// 分段埃氏筛:位图只存奇数,每段32KB刚好放进L1缓存;
+// 3,5,7,11,13的倍数事先做成周期为15015位的轮模板,每段直接按字拷贝,
+// 其余基础质数再逐个划掉.区间[n, m]只筛需要的那几段,支持到10^10以上.
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+using namespace std;
+
+const uint64_t SIEVE_SEGMENT_BITS = 32768 * 8;                 // 每段的奇数个数
+const uint64_t SIEVE_WHEEL_PRIMES[] = {3, 5, 7, 11, 13};
+const uint64_t SIEVE_WHEEL_PERIOD = 3 * 5 * 7 * 11 * 13;       // 轮模板的周期(以奇数计)
+
+// 不超过x的最大整数平方根
+inline uint64_t isqrt64(uint64_t x) {
+    uint64_t r = (uint64_t)sqrtl((long double)x);
+    while (r * r > x) --r;
+    while ((r + 1) * (r + 1) <= x) ++r;
+    return r;
+}
+
+// 轮模板:第k位对应奇数2k+1,为1表示不是3~13的倍数;多存两个字方便跨字读取
+inline const vector<uint64_t>& sieveWheelPattern() {
+    static const vector<uint64_t> pattern = [] {
+        vector<uint64_t> bits((SIEVE_WHEEL_PERIOD + 127) / 64 + 1, 0);
+        for (uint64_t k = 0; k < bits.size() * 64; ++k) {
+            uint64_t value = 2 * k + 1;
+            bool candidate = true;
+            for (uint64_t p : SIEVE_WHEEL_PRIMES) {
+                if (value % p == 0) {
+                    candidate = false;
+                    break;
+                }
+            }
+            if (candidate) bits[k >> 6] |= 1ULL << (k & 63);
+        }
+        return bits;
+    }();
+    return pattern;
+}
+
+// 用于筛[.., m]的基础质数:不超过sqrt(m)且不在轮里的奇质数
+inline vector<uint64_t> sieveBasePrimes(uint64_t m) {
+    uint64_t limit = isqrt64(m);
+    vector<bool> composite(limit + 1, false);
+    vector<uint64_t> primes;
+    for (uint64_t i = 3; i <= limit; i += 2) {
+        if (composite[i]) continue;
+        if (i > SIEVE_WHEEL_PRIMES[4]) primes.push_back(i);
+        for (uint64_t j = i * i; j <= limit; j += 2 * i) {
+            composite[j] = true;
+        }
+    }
+    return primes;
+}
+
+// 筛一段奇数[low, low + 2 * count),low为奇数;bits中第j位为1表示low + 2j是质数
+inline void sieveSegment(uint64_t low, uint64_t count, const vector<uint64_t>& basePrimes, vector<uint64_t>& bits) {
+    const vector<uint64_t>& pattern = sieveWheelPattern();
+    size_t words = (count + 63) / 64;
+    bits.assign(words, 0);
+
+    // 拷贝轮模板
+    uint64_t pos = ((low - 1) / 2) % SIEVE_WHEEL_PERIOD;
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t q = pos >> 6, r = pos & 63;
+        bits[w] = r ? (pattern[q] >> r) | (pattern[q + 1] << (64 - r)) : pattern[q];
+        pos += 64;
+        if (pos >= SIEVE_WHEEL_PERIOD) pos -= SIEVE_WHEEL_PERIOD;
+    }
+    if (count % 64) bits[words - 1] &= (1ULL << (count % 64)) - 1;
+
+    uint64_t high = low + 2 * count;   // 不含
+    // 轮里的质数自己被模板划掉了,1也不是质数
+    if (low == 1) bits[0] &= ~1ULL;
+    for (uint64_t p : SIEVE_WHEEL_PRIMES) {
+        if (p >= low && p < high) {
+            uint64_t j = (p - low) / 2;
+            bits[j >> 6] |= 1ULL << (j & 63);
+        }
+    }
+
+    for (uint64_t p : basePrimes) {
+        if (p * p >= high) break;
+        uint64_t start = max(p * p, (low + p - 1) / p * p);
+        if (start % 2 == 0) start += p;
+        for (uint64_t j = (start - low) / 2; j < count; j += p) {
+            bits[j >> 6] &= ~(1ULL << (j & 63));
+        }
+    }
+}
+
+// 按递增顺序对[n, m]内的每个质数调用f,内存占用与区间长度无关
+template <class F>
+void forEachPrime(uint64_t n, uint64_t m, F f, const vector<uint64_t>* basePrimes = nullptr) {
+    if (m < 2 || n > m) return;
+    if (n <= 2) f(uint64_t(2));
+    uint64_t low = max<uint64_t>(n, 3) | 1;   // 第一个不小于n的奇数
+    if (low > m) return;
+    vector<uint64_t> ownBase;
+    if (basePrimes == nullptr) {
+        ownBase = sieveBasePrimes(m);
+        basePrimes = &ownBase;
+    }
+    vector<uint64_t> bits;
+    while (low <= m) {
+        uint64_t count = min(SIEVE_SEGMENT_BITS, (m - low) / 2 + 1);
+        sieveSegment(low, count, *basePrimes, bits);
+        for (size_t w = 0; w < bits.size(); ++w) {
+            uint64_t word = bits[w];
+            while (word) {
+                uint64_t j = w * 64 + __builtin_ctzll(word);
+                f(low + 2 * j);
+                word &= word - 1;
+            }
+        }
+        if (count < SIEVE_SEGMENT_BITS) break;
+        low += 2 * count;
+    }
+}
+
+// 把[n, m]按段对齐切成至多threads块,供多线程各筛一块
+inline vector<pair<uint64_t, uint64_t>> sieveChunks(uint64_t n, uint64_t m, unsigned threads) {
+    uint64_t step = 2 * SIEVE_SEGMENT_BITS;
+    uint64_t span = m - n + 1;
+    uint64_t chunk = max(step, (span / max(threads, 1u) + step - 1) / step * step);
+    vector<pair<uint64_t, uint64_t>> chunks;
+    for (uint64_t lo = n; ; lo += chunk) {
+        if (m - lo < chunk) {
+            chunks.push_back({lo, m});
+            break;
+        }
+        chunks.push_back({lo, lo + chunk - 1});
+    }
+    return chunks;
+}
+
+// 返回[n, m]内的全部质数;threads > 1时分块并行筛,结果仍然递增
+inline vector<uint64_t> primesInRange(uint64_t n, uint64_t m, unsigned threads = 1) {
+    vector<uint64_t> result;
+    if (m < 2 || n > m) return result;
+    if (threads <= 1) {
+        forEachPrime(n, m, [&](uint64_t p) { result.push_back(p); });
+        return result;
+    }
+
+    vector<uint64_t> basePrimes = sieveBasePrimes(m);
+    vector<pair<uint64_t, uint64_t>> chunks = sieveChunks(n, m, threads);
+    vector<vector<uint64_t>> parts(chunks.size());
+    vector<thread> workers;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        workers.emplace_back([&, i] {
+            forEachPrime(chunks[i].first, chunks[i].second, [&](uint64_t p) { parts[i].push_back(p); }, &basePrimes);
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    for (const vector<uint64_t>& part : parts) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    return result;
+}
+
+// 统计[n, m]内质数个数,不保存质数本身,适合10^10这样的大区间
+inline uint64_t countPrimes(uint64_t n, uint64_t m, unsigned threads = 1) {
+    if (m < 2 || n > m) return 0;
+    vector<uint64_t> basePrimes = sieveBasePrimes(m);
+    vector<pair<uint64_t, uint64_t>> chunks = sieveChunks(n, m, threads);
+    vector<uint64_t> counts(chunks.size(), 0);
+    vector<thread> workers;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        workers.emplace_back([&, i] {
+            uint64_t c = 0;
+            forEachPrime(chunks[i].first, chunks[i].second, [&](uint64_t) { ++c; }, &basePrimes);
+            counts[i] = c;
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    uint64_t total = 0;
+    for (uint64_t c : counts) total += c;
+    return total;
+}
+
+#endif
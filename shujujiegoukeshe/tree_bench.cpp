@@ -0,0 +1,235 @@
+// 4.cpp的AVL树、8.cpp的B树与std::set的性能对比
+// 用法: tree_bench [最大规模指数] [最小规模指数],默认规模为10^3 ~ 10^6,最大可到10^8
+// 每个(结构, 负载, 规模)在单独的子进程里运行,这样峰值内存互不影响;
+// Linux下同时用perf_event读取缓存未命中次数,不可用时显示n/a.
+// 三种结构在同一(负载, 规模)下的校验和必须相同,否则报告不一致并以非0退出.
+#include <iostream>
+#include <vector>
+#include <set>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "avl_tree.h"
+#include "b_tree.h"
+#include "bench_util.h"
+using namespace std;
+
+// 统一三种结构的接口
+struct AVLBench {
+    static const char* name() { return "avl"; }
+    AVLTree tree;
+    void insert(int x) { tree.insert(x); }
+    void erase(int x) { tree.deleteNode(x); }
+    bool contains(int x) const { return tree.search(x); }
+    size_t range(int lo, int hi) const {
+        size_t c = 0;
+        for (AVLTree::Iterator it = tree.lower_bound(lo); it.valid() && *it <= hi; ++it) ++c;
+        return c;
+    }
+};
+
+struct BTreeBench {
+    static const char* name() { return "btree"; }
+    Node* root = nullptr;
+    ~BTreeBench() { destroy(root); }
+    void insert(int x) { ::insert(root, x); }
+    void erase(int x) { remove(root, x); }
+    bool contains(int x) const { return Find(root, x) != nullptr; }
+    size_t range(int lo, int hi) const {
+        size_t c = 0;
+        rangeCount(root, lo, hi, c);
+        return c;
+    }
+    // 中序访问与[lo, hi]相交的子树
+    static void rangeCount(Node* node, int lo, int hi, size_t& c) {
+        if (!node) return;
+        size_t i = lower_bound(node->data.begin(), node->data.end(), lo) - node->data.begin();
+        for (; i <= node->data.size(); ++i) {
+            if (!node->leaf) rangeCount(node->next[i], lo, hi, c);
+            if (i == node->data.size() || node->data[i] > hi) break;
+            ++c;
+        }
+    }
+};
+
+struct SetBench {
+    static const char* name() { return "std::set"; }
+    set<int> s;
+    void insert(int x) { s.insert(x); }
+    void erase(int x) { s.erase(x); }
+    bool contains(int x) const { return s.count(x) != 0; }
+    size_t range(int lo, int hi) const {
+        size_t c = 0;
+        for (auto it = s.lower_bound(lo); it != s.end() && *it <= hi; ++it) ++c;
+        return c;
+    }
+};
+
+// 一次运行的结果
+struct BenchResult {
+    double seconds;
+    size_t ops;
+    double p50, p99, p999;   // 单次操作延迟(ns),每16次抽样一次
+    double peakMB;
+    double bytesPerKey;
+    long long cacheMisses;   // -1表示不可用
+    size_t checksum;         // 各次操作的返回值之和加上结束时树中的键数,三种结构必须一致
+};
+
+const int SAMPLE_EVERY = 16;
+
+#ifdef __linux__
+int openCacheMissCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+// 对ops次操作计时;op(i)执行第i次操作并返回一个参与校验和的值
+template <class Op>
+void timeOps(size_t ops, Op op, BenchResult& result) {
+    vector<double> samples;
+    samples.reserve(ops / SAMPLE_EVERY + 1);
+    size_t checksum = 0;
+#ifdef __linux__
+    int fd = openCacheMissCounter();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        if (i % SAMPLE_EVERY == 0) {
+            auto a = chrono::steady_clock::now();
+            checksum += op(i);
+            auto b = chrono::steady_clock::now();
+            samples.push_back(chrono::duration<double, nano>(b - a).count());
+        } else {
+            checksum += op(i);
+        }
+    }
+    auto stop = chrono::steady_clock::now();
+    result.cacheMisses = -1;
+#ifdef __linux__
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long misses = 0;
+        if (read(fd, &misses, sizeof(misses)) == sizeof(misses)) result.cacheMisses = misses;
+        close(fd);
+    }
+#endif
+    result.seconds = chrono::duration<double>(stop - start).count();
+    result.ops = ops;
+    result.checksum = checksum;
+    sort(samples.begin(), samples.end());
+    auto pct = [&](double p) {
+        if (samples.empty()) return 0.0;
+        return samples[min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    result.p50 = pct(0.50);
+    result.p99 = pct(0.99);
+    result.p999 = pct(0.999);
+}
+
+// 各种负载;键取偶数,查询时奇数即为不存在的键
+template <class Tree>
+BenchResult runWorkload(const string& workload, size_t n) {
+    BenchResult result;
+    mt19937 rng(12345);
+    vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (int)(2 * i);
+    vector<int> shuffled = keys;
+    shuffle(shuffled.begin(), shuffled.end(), rng);
+    size_t baseRSS = currentRSS();
+
+    Tree tree;
+    if (workload == "seq-insert") {
+        timeOps(n, [&](size_t i) { tree.insert(keys[i]); return 0; }, result);
+    } else if (workload == "rand-insert") {
+        timeOps(n, [&](size_t i) { tree.insert(shuffled[i]); return 0; }, result);
+    } else {
+        for (int k : shuffled) tree.insert(k);
+        if (workload == "lookup") {
+            vector<int> queries(n);
+            for (size_t i = 0; i < n; ++i) queries[i] = (int)(rng() % (2 * n));
+            timeOps(n, [&](size_t i) { return (size_t)tree.contains(queries[i]); }, result);
+        } else if (workload == "delete") {
+            timeOps(n, [&](size_t i) { tree.erase(shuffled[i]); return 0; }, result);
+        } else if (workload == "range") {
+            // 每次扫描约100个键
+            size_t scans = max<size_t>(n / 100, 1);
+            vector<int> starts(scans);
+            for (size_t i = 0; i < scans; ++i) starts[i] = (int)(rng() % (2 * n));
+            timeOps(scans, [&](size_t i) { return tree.range(starts[i], starts[i] + 199); }, result);
+        }
+    }
+
+    // 插入和删除本身不返回信息,用结束时的键数核对它们的结果
+    result.checksum += tree.range(-1, (int)(2 * n));
+
+    size_t peak = peakRSS();
+    result.peakMB = peak / 1048576.0;
+    result.bytesPerKey = peak > baseRSS ? (double)(peak - baseRSS) / n : 0;
+    return result;
+}
+
+// 运行并打印一行结果;失败时返回false,否则把校验和存入checksum
+template <class Tree>
+bool report(const string& workload, size_t n, size_t& checksum) {
+    BenchResult r;
+    if (!runIsolated(r, [&] { return runWorkload<Tree>(workload, n); })) {
+        printf("%-9s %-12s %10zu  failed\n", Tree::name(), workload.c_str(), n);
+        return false;
+    }
+    checksum = r.checksum;
+    char misses[32] = "n/a";
+    if (r.cacheMisses >= 0) snprintf(misses, sizeof(misses), "%.2f", (double)r.cacheMisses / r.ops);
+    printf("%-9s %-12s %10zu %10.3f %9.0f %9.0f %9.0f %9.1f %8.1f %10s\n",
+           Tree::name(), workload.c_str(), n, r.ops / r.seconds / 1e6,
+           r.p50, r.p99, r.p999, r.peakMB, r.bytesPerKey, misses);
+    fflush(stdout);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int maxExp = argc > 1 ? atoi(argv[1]) : 6;
+    int minExp = argc > 2 ? atoi(argv[2]) : 3;
+    const char* workloads[] = {"seq-insert", "rand-insert", "lookup", "delete", "range"};
+    bool ok = true;
+
+    printf("%-9s %-12s %10s %10s %9s %9s %9s %9s %8s %10s\n",
+           "tree", "workload", "n", "Mops/s", "p50(ns)", "p99(ns)", "p999(ns)", "peakMB", "B/key", "miss/op");
+    for (int e = minExp; e <= maxExp; ++e) {
+        size_t n = 1;
+        for (int i = 0; i < e; ++i) n *= 10;
+        for (const char* w : workloads) {
+            size_t avl = 0, btree = 0, stdSet = 0;
+            bool ran = report<AVLBench>(w, n, avl);
+            ran = report<BTreeBench>(w, n, btree) && ran;
+            ran = report<SetBench>(w, n, stdSet) && ran;
+            if (!ran || avl != stdSet || btree != stdSet) {
+                printf("%-12s %10zu  结果不一致: avl %zu, btree %zu, std::set %zu\n", w, n, avl, btree, stdSet);
+                ok = false;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}